@@ -2,6 +2,7 @@
 // Copyright (C) 2024-2025 Petr Vyazovik <xen@f-m.fm>
 
 #include "config.h"
+#include "ids_embedded.h"
 #include "log.h"
 #include "pciex_version.h"
 #include "util.h"
@@ -136,9 +137,15 @@ static bool CommonConfigIsValid(const PCIexCommonCfg &common_cfg)
         return false;
     }
 
-    // check if hwdata db file exist
+    if (common_cfg.populate_workers > max_populate_workers) {
+        std::print("cfg.common: Number of populate workers should be in range [0 to {}]\n",
+                   max_populate_workers);
+        return false;
+    }
+
+    // check if hwdata db file exist, it's not needed if the db has been compiled in
     std::filesystem::directory_entry hwdata_db_dir_e {common_cfg.hwdata_db_path};
-    if (!hwdata_db_dir_e.exists()) {
+    if (!hwdata_db_dir_e.exists() && !pci::embedded::Available()) {
         std::print("cfg.common: hwdata db [{}] doesn't exist\n", common_cfg.hwdata_db_path);
         return false;
     }
@@ -41,6 +41,8 @@ struct CmdLOpts
 
 void ParseCmdLineOptions(CmdLOpts &cmdl_opts, int argc, char *argv[]);
 
+constexpr uint8_t max_populate_workers = 64;
+
 // Common config
 struct PCIexCommonCfg
 {
@@ -50,6 +52,21 @@ struct PCIexCommonCfg
 
     // PCI ids database default location
     std::string hwdata_db_path {"/usr/share/hwdata/pci.ids"};
+
+    // Parse the whole PCI ids database into an immutable index at startup
+    // instead of searching and caching names on demand.
+    // Lookups are lock-free then and can be performed from multiple threads.
+    bool hwdata_db_index {false};
+
+    // Use PCI ids database compiled into the binary (see PCIEX_EMBED_PCI_IDS
+    // build option) even if @hwdata_db_path exists.
+    // Embedded database is always used as a fallback if @hwdata_db_path is missing.
+    bool hwdata_db_embedded {false};
+
+    // Number of worker threads decoding devices while the provider is still
+    // producing device descriptors. 0 disables pipelined topology population.
+    // Unless the PCI ids database is indexed or embedded, ids lookups are serialized.
+    uint8_t populate_workers {0};
 };
 
 // TUI config
@@ -59,9 +76,27 @@ struct PCIexTUICfg
     // mode by default (or compact otherwise).
     bool dt_dflt_draw_verbose {false};
 
+    // VFs of SR-IOV physical functions on the device tree pane are collapsed
+    // under their PF by default, so they don't clutter the tree.
+    bool dt_dflt_collapse_vfs {true};
+
     // Highlighted device registers would be preserved on device switch.
     // When switching back to this device, registers highlighting state would be restored.
     bool keep_dev_selected_regs {true};
+
+    // Register components of the recently selected devices are kept built,
+    // so switching back to them is instant. Least recently used ones are
+    // rebuilt on demand once either of the limits below is exceeded,
+    // only their registers highlighting state is kept.
+    // Max number of devices with cached register components.
+    uint32_t regs_comp_cache_size {128};
+    // Approximate memory budget of the cached register components in KiB.
+    uint32_t regs_comp_cache_budget_kb {65536};
+
+    // Topology is populated in the background, while the UI is already up
+    // and shows the devices loaded so far. Otherwise UI starts only after
+    // the topology has been populated completely.
+    bool async_topology_load {true};
 };
 
 struct PCIexCfg
@@ -0,0 +1,60 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2025 Petr Vyazovik <xen@f-m.fm>
+
+#include "ids_embedded.h"
+#include "util.h"
+
+namespace pci::embedded {
+
+#ifdef PCIEX_EMBEDDED_IDS
+
+// defined in generated pci_ids_embedded.cpp
+extern const char     ids_names[];
+extern const char     ids_version[];
+extern const IdsTable ids_tables[e_to_type(IdsTableType::TABLES_CNT)];
+
+bool Available() noexcept
+{
+    return true;
+}
+
+std::string_view Version() noexcept
+{
+    return ids_version;
+}
+
+std::string_view Lookup(const IdsTableType type, const uint64_t key) noexcept
+{
+    const auto &table = ids_tables[e_to_type(type)];
+    if (table.slots_cnt_ == 0)
+        return {};
+
+    auto disp = table.disp_[IdsHash(key, 0) % table.disp_cnt_];
+    const auto &slot = table.slots_[IdsHash(key, disp) % table.slots_cnt_];
+    if (slot.name_len_ == 0 || slot.key_ != key)
+        return {};
+
+    return {ids_names + slot.name_off_, slot.name_len_};
+}
+
+#else
+
+bool Available() noexcept
+{
+    return false;
+}
+
+std::string_view Version() noexcept
+{
+    return {};
+}
+
+std::string_view Lookup([[maybe_unused]] const IdsTableType type,
+                        [[maybe_unused]] const uint64_t key) noexcept
+{
+    return {};
+}
+
+#endif
+
+} // namespace pci::embedded
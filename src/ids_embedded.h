@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2025 Petr Vyazovik <xen@f-m.fm>
+
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+// PCI ids database compiled into the binary.
+// Tables are generated at build time from the pci.ids file passed via
+// PCIEX_EMBED_PCI_IDS cmake option (see tools/ids_embed_gen.cpp).
+namespace pci::embedded {
+
+enum class IdsTableType
+{
+    VENDOR,      // key: VID
+    DEVICE,      // key: VID << 16 | device ID
+    SUBSYS,      // key: VID << 48 | device ID << 32 | subsystem VID << 16 | subsystem ID
+    CLASS,       // key: base class
+    SUBCLASS,    // key: base class << 8 | subclass
+    PROG_IFACE,  // key: base class << 16 | subclass << 8 | programming interface
+
+    TABLES_CNT
+};
+
+// Slot of perfect-hashed table. Empty slots have zero @name_len_.
+struct IdsEntry
+{
+    uint64_t key_;
+    uint32_t name_off_;
+    uint32_t name_len_;
+};
+
+// Two-level (hash and displace) perfect hash table:
+// the key is hashed into one of @disp_cnt_ buckets first, then bucket displacement
+// value is used as a seed of the second hash, which gives the slot index.
+struct IdsTable
+{
+    const IdsEntry *slots_;
+    uint32_t        slots_cnt_;
+    const uint32_t *disp_;
+    uint32_t        disp_cnt_;
+};
+
+// Shared by the generator and the lookup code, so must never change
+// independently of each other
+constexpr uint64_t IdsHash(const uint64_t key, const uint32_t seed) noexcept
+{
+    uint64_t h = key + 0x9e3779b97f4a7c15ULL * (static_cast<uint64_t>(seed) + 1);
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+    return h ^ (h >> 31);
+}
+
+// Check if the db has been compiled in
+bool Available() noexcept;
+
+// Version string of the embedded db
+std::string_view Version() noexcept;
+
+// Get the name of the entry, empty string_view is returned if nothing has been found
+std::string_view Lookup(const IdsTableType type, const uint64_t key) noexcept;
+
+} // namespace pci::embedded
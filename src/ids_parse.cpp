@@ -1,11 +1,16 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 // Copyright (C) 2023-2025 Petr Vyazovik <xen@f-m.fm>
 
+#include <algorithm>
+#include <charconv>
 #include <cstdint>
 #include <filesystem>
 #include <format>
+#include <limits>
+#include <span>
 
 #include "config.h"
+#include "ids_embedded.h"
 #include "ids_parse.h"
 #include "log.h"
 
@@ -20,6 +25,16 @@ PciIdParser::PciIdParser()
 {
     auto ids_db_path = fs::path(pciex_cfg.common.hwdata_db_path);
     auto ids_db_entry = fs::directory_entry(ids_db_path);
+
+    // Embedded db needs neither file reading nor index building
+    if (embedded::Available() &&
+        (pciex_cfg.common.hwdata_db_embedded || !ids_db_entry.exists())) {
+        logger.log(Verbosity::INFO, "Using embedded PCI ids db, version {}",
+                   embedded::Version());
+        use_embedded_db_ = true;
+        return;
+    }
+
     db_size_ = ids_db_entry.file_size();
 
     logger.log(Verbosity::INFO, "PCI ids path: {} -> size: {}", ids_db_path.string(), db_size_);
@@ -40,15 +55,185 @@ PciIdParser::PciIdParser()
 
     db_str_ = std::string_view(buf_.get(), db_size_);
     ids_cache_.clear();
+
+    if (pciex_cfg.common.hwdata_db_index)
+        BuildIndex();
+}
+
+// Parse hex ID of fixed length at the beginning of @str
+static bool ParseHexId(std::string_view str, size_t len, uint32_t &id)
+{
+    if (str.length() < len)
+        return false;
+
+    auto [ptr, ec] = std::from_chars(str.data(), str.data() + len, id, 16);
+    return ec == std::errc() && ptr == str.data() + len;
+}
+
+// Get entry name, which is separated from the ID(s) by two WS
+static std::string_view EntryName(std::string_view line, size_t name_off)
+{
+    if (line.length() <= name_off)
+        return {};
+    return line.substr(name_off);
+}
+
+// PCI ids db consists of two blocks:
+// vendor -> device -> subsystem entries:
+//   vvvv  vendor_name
+//   \tdddd  device_name
+//   \t\tssss ssss  subsystem_name
+// and class -> subclass -> programming interface entries:
+//   C cc  class_name
+//   \tss  subclass_name
+//   \t\tpp  prog-if_name
+// Each level is stored in its own flat array, children of an entry are
+// located contiguously within the next level array.
+void PciIdParser::BuildIndex()
+{
+    auto index = std::make_unique<IdsIndex>();
+    constexpr auto no_parent = std::numeric_limits<size_t>::max();
+
+    bool   in_class_block = false;
+    size_t lvl1_idx = no_parent, lvl2_idx = no_parent;
+    size_t pos = 0;
+
+    auto add_entry = [](std::vector<IdsIndexEntry> &lvl, std::vector<IdsIndexEntry> *parent_lvl,
+                        size_t parent_idx, uint32_t key, std::string_view name,
+                        size_t child_first) {
+        if (parent_lvl != nullptr) {
+            if (parent_idx == no_parent)
+                return no_parent;
+            (*parent_lvl)[parent_idx].child_cnt_++;
+        }
+        lvl.push_back({key, static_cast<uint32_t>(child_first), 0, name});
+        return lvl.size() - 1;
+    };
+
+    while (pos < db_str_.length()) {
+        auto eol = db_str_.find('\n', pos);
+        if (eol == std::string_view::npos)
+            eol = db_str_.length();
+
+        auto line = db_str_.substr(pos, eol - pos);
+        pos = eol + 1;
+
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        uint32_t id, sub_id;
+
+        if (line.starts_with("C ")) {
+            // 'C' + WS + two digits + two WS
+            in_class_block = true;
+            lvl2_idx = no_parent;
+            lvl1_idx = ParseHexId(line.substr(2), 2, id) ?
+                       add_entry(index->classes_, nullptr, 0, id, EntryName(line, 6),
+                                 index->subclasses_.size()) :
+                       no_parent;
+        } else if (line[0] != '\t') {
+            // VID (4 chars) + two WS
+            in_class_block = false;
+            lvl2_idx = no_parent;
+            lvl1_idx = ParseHexId(line, 4, id) ?
+                       add_entry(index->vendors_, nullptr, 0, id, EntryName(line, 6),
+                                 index->devices_.size()) :
+                       no_parent;
+        } else if (line.length() < 2 || line[1] != '\t') {
+            // second level entry
+            auto id_len = in_class_block ? 2 : 4;
+            if (!ParseHexId(line.substr(1), id_len, id)) {
+                lvl2_idx = no_parent;
+                continue;
+            }
+
+            if (in_class_block)
+                lvl2_idx = add_entry(index->subclasses_, &index->classes_, lvl1_idx, id,
+                                     EntryName(line, 1 + 2 + 2), index->prog_ifaces_.size());
+            else
+                lvl2_idx = add_entry(index->devices_, &index->vendors_, lvl1_idx, id,
+                                     EntryName(line, 1 + 4 + 2), index->subsystems_.size());
+        } else {
+            // third level entry
+            if (in_class_block) {
+                if (ParseHexId(line.substr(2), 2, id))
+                    add_entry(index->prog_ifaces_, &index->subclasses_, lvl2_idx, id,
+                              EntryName(line, 2 + 2 + 2), 0);
+            } else {
+                // subsystem vendor ID + WS + subsystem ID
+                if (ParseHexId(line.substr(2), 4, id) && line.length() > 7 &&
+                    ParseHexId(line.substr(7), 4, sub_id))
+                    add_entry(index->subsystems_, &index->devices_, lvl2_idx,
+                              id << 16 | sub_id, EntryName(line, 2 + 4 + 1 + 4 + 2), 0);
+            }
+        }
+    }
+
+    // db is expected to be sorted, but it's not guaranteed for every level,
+    // so sort every range of siblings explicitly
+    auto sort_children = [](const std::vector<IdsIndexEntry> &parent_lvl,
+                            std::vector<IdsIndexEntry> &lvl) {
+        for (const auto &parent : parent_lvl) {
+            auto first = lvl.begin() + parent.child_first_;
+            std::ranges::sort(first, first + parent.child_cnt_, {}, &IdsIndexEntry::key_);
+        }
+    };
+
+    sort_children(index->devices_, index->subsystems_);
+    sort_children(index->vendors_, index->devices_);
+    std::ranges::sort(index->vendors_, {}, &IdsIndexEntry::key_);
+
+    sort_children(index->subclasses_, index->prog_ifaces_);
+    sort_children(index->classes_, index->subclasses_);
+    std::ranges::sort(index->classes_, {}, &IdsIndexEntry::key_);
+
+    logger.log(Verbosity::INFO,
+               "PCI ids index: vendors {} devices {} subsystems {} classes {} subclasses {} prog-ifs {}",
+               index->vendors_.size(), index->devices_.size(), index->subsystems_.size(),
+               index->classes_.size(), index->subclasses_.size(), index->prog_ifaces_.size());
+
+    ids_index_ = std::move(index);
+}
+
+static const IdsIndexEntry *
+IndexFind(std::span<const IdsIndexEntry> entries, const uint32_t key) noexcept
+{
+    auto it = std::ranges::lower_bound(entries, key, {}, &IdsIndexEntry::key_);
+    if (it == entries.end() || it->key_ != key)
+        return nullptr;
+    return &*it;
+}
+
+static std::span<const IdsIndexEntry>
+IndexChildren(const std::vector<IdsIndexEntry> &lvl, const IdsIndexEntry *parent) noexcept
+{
+    return {lvl.data() + parent->child_first_, parent->child_cnt_};
+}
+
+static const IdsIndexEntry *
+IndexDeviceFind(const IdsIndex &index, const uint16_t vid, const uint16_t dev_id) noexcept
+{
+    auto vendor = IndexFind(index.vendors_, vid);
+    if (vendor == nullptr)
+        return nullptr;
+    return IndexFind(IndexChildren(index.devices_, vendor), dev_id);
 }
 
 std::string_view PciIdParser::vendor_name_lookup(const uint16_t vid)
 {
+    if (use_embedded_db_)
+        return embedded::Lookup(embedded::IdsTableType::VENDOR, vid);
+
+    if (ids_index_) {
+        auto vendor = IndexFind(ids_index_->vendors_, vid);
+        return vendor ? vendor->name_ : std::string_view{};
+    }
+
     /* search in cache first */
     auto cached_vid_desc = ids_cache_.find(vid);
     if (cached_vid_desc != ids_cache_.end())
     {
-        logger.log(Verbosity::INFO, "Found cached vendor desc for VID {:x} db off {}",
+        logger.log(Verbosity::RAW, "Found cached vendor desc for VID {:x} db off {}",
                    vid, cached_vid_desc->second.vendor_db_off_);
         return cached_vid_desc->second.vendor_name_;
     }
@@ -92,6 +277,15 @@ std::string_view PciIdParser::vendor_name_lookup(const uint16_t vid)
 std::string_view PciIdParser::device_name_lookup(const uint16_t vid,
                                                    const uint16_t dev_id)
 {
+    if (use_embedded_db_)
+        return embedded::Lookup(embedded::IdsTableType::DEVICE,
+                                static_cast<uint64_t>(vid) << 16 | dev_id);
+
+    if (ids_index_) {
+        auto device = IndexDeviceFind(*ids_index_, vid, dev_id);
+        return device ? device->name_ : std::string_view{};
+    }
+
     /* vendor name and db offset should have been cached */
     auto cached_vid_desc = ids_cache_.find(vid);
     if (cached_vid_desc == ids_cache_.end())
@@ -104,7 +298,7 @@ std::string_view PciIdParser::device_name_lookup(const uint16_t vid,
     /* Try to obtain device name from cache */
     auto cached_dev_desc = cached_vid_desc->second.devs_.find(dev_id);
     if (cached_dev_desc != cached_vid_desc->second.devs_.end()) {
-        logger.log(Verbosity::INFO, "Found device {:x} [{}] db off {} in cache",
+        logger.log(Verbosity::RAW, "Found device {:x} [{}] db off {} in cache",
                    dev_id, cached_dev_desc->second.device_name_,
                    cached_dev_desc->second.device_db_off_);
         return cached_dev_desc->second.device_name_;
@@ -146,6 +340,22 @@ std::string_view PciIdParser::device_name_lookup(const uint16_t vid,
 std::string_view PciIdParser::subsys_name_lookup(const uint16_t vid, const uint16_t dev_id,
                                             const uint16_t subsys_vid, const uint16_t subsys_id)
 {
+    if (use_embedded_db_)
+        return embedded::Lookup(embedded::IdsTableType::SUBSYS,
+                                static_cast<uint64_t>(vid) << 48 |
+                                static_cast<uint64_t>(dev_id) << 32 |
+                                static_cast<uint64_t>(subsys_vid) << 16 | subsys_id);
+
+    if (ids_index_) {
+        auto device = IndexDeviceFind(*ids_index_, vid, dev_id);
+        if (device == nullptr)
+            return std::string_view{};
+
+        auto subsys = IndexFind(IndexChildren(ids_index_->subsystems_, device),
+                                static_cast<uint32_t>(subsys_vid) << 16 | subsys_id);
+        return subsys ? subsys->name_ : std::string_view{};
+    }
+
     /* vendor name and db offset should have been cached */
     auto cached_vid_desc = ids_cache_.find(vid);
     if (cached_vid_desc == ids_cache_.end())
@@ -219,6 +429,36 @@ std::string_view PciIdParser::subsys_name_lookup(const uint16_t vid, const uint1
 
 ClassCodeInfo PciIdParser::class_info_lookup(const uint32_t ccode)
 {
+    if (use_embedded_db_) {
+        using embedded::IdsTableType;
+        auto class_name = embedded::Lookup(IdsTableType::CLASS, ccode >> 16 & 0xff);
+        if (class_name.empty())
+            return {{},{},{}};
+
+        auto subclass_name = embedded::Lookup(IdsTableType::SUBCLASS, ccode >> 8 & 0xffff);
+        if (subclass_name.empty())
+            return {class_name, {}, {}};
+
+        return {class_name, subclass_name,
+                embedded::Lookup(IdsTableType::PROG_IFACE, ccode & 0xffffff)};
+    }
+
+    if (ids_index_) {
+        auto class_e = IndexFind(ids_index_->classes_, ccode >> 16 & 0xff);
+        if (class_e == nullptr)
+            return {{},{},{}};
+
+        auto subclass_e = IndexFind(IndexChildren(ids_index_->subclasses_, class_e),
+                                    ccode >> 8 & 0xff);
+        if (subclass_e == nullptr)
+            return {class_e->name_, {}, {}};
+
+        auto prog_iface_e = IndexFind(IndexChildren(ids_index_->prog_ifaces_, subclass_e),
+                                      ccode & 0xff);
+        return {class_e->name_, subclass_e->name_,
+                prog_iface_e ? prog_iface_e->name_ : std::string_view{}};
+    }
+
     if (class_code_db_off_ == 0) {
         auto class_block_start = db_str_.rfind("C 00");
         if (class_block_start == std::string_view::npos) {
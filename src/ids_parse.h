@@ -6,6 +6,7 @@
 #include <unordered_map>
 #include <string_view>
 #include <memory>
+#include <vector>
 
 namespace pci {
 
@@ -33,6 +34,33 @@ struct CachedDbVendorEntry
 //                 class name,       subclass name,    programming interface
 typedef std::tuple<std::string_view, std::string_view, std::string_view> ClassCodeInfo;
 
+// Immutable index entry of PCI ids db.
+// @key_ is either the ID of the entry itself (vendor, device, class, ...)
+// or a pair of IDs packed into a single value (subsystem vendor ID + subsystem ID).
+// Child entries (devices of particular vendor, subsystems of particular device, etc)
+// are stored in the next level array within [child_first_, child_first_ + child_cnt_) range.
+struct IdsIndexEntry
+{
+    uint32_t         key_;
+    uint32_t         child_first_;
+    uint32_t         child_cnt_;
+    std::string_view name_;
+};
+
+// Flat sorted arrays holding the whole PCI ids db.
+// Once built, the index is never modified, so lookups are lock-free
+// and can be safely performed from multiple threads at once.
+struct IdsIndex
+{
+    std::vector<IdsIndexEntry> vendors_;
+    std::vector<IdsIndexEntry> devices_;
+    std::vector<IdsIndexEntry> subsystems_;
+
+    std::vector<IdsIndexEntry> classes_;
+    std::vector<IdsIndexEntry> subclasses_;
+    std::vector<IdsIndexEntry> prog_ifaces_;
+};
+
 struct PciIdParser
 {
     size_t                  db_size_ {0};
@@ -43,7 +71,21 @@ struct PciIdParser
 
     std::unordered_map<uint16_t, CachedDbVendorEntry> ids_cache_;
 
+    // Pre-built index. When present, all lookups are served from it
+    // and @ids_cache_ is not touched.
+    std::unique_ptr<const IdsIndex> ids_index_;
+
+    // PCI ids db compiled into the binary is used
+    bool use_embedded_db_ {false};
+
     PciIdParser();
+
+    // Parse the whole db into @ids_index_
+    void BuildIndex();
+    bool IndexReady() const noexcept { return ids_index_ != nullptr; }
+    // Lookups don't touch @ids_cache_ and can be performed concurrently
+    bool IsThreadSafe() const noexcept { return IndexReady() || use_embedded_db_; }
+
     std::string_view vendor_name_lookup(const uint16_t vid);
     std::string_view device_name_lookup(const uint16_t vid, const uint16_t dev_id);
     std::string_view subsys_name_lookup(const uint16_t vid, const uint16_t dev_id,
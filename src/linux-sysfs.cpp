@@ -38,7 +38,7 @@ SysfsProvider::GetBusDescriptors()
         } else {
             auto bus_entry = fs::read_symlink(bus_dir_e);
             uint32_t dom, bus;
-            auto res = sscanf(bus_entry.filename().c_str(), "%4u:%2x", &dom, &bus);
+            auto res = sscanf(bus_entry.filename().c_str(), "%x:%2x", &dom, &bus);
             if (res != 2) {
                 logger.log(Verbosity::WARN, "Failed to parse bus symlink");
                 return {};
@@ -60,7 +60,7 @@ SysfsProvider::GetBusDescriptors()
 
             if (bs[pos + 2] == 'p')
                 is_root_bus = true;
-            logger.log(Verbosity::INFO, "Got bus entry: [{:04}:{:02x}] is root: {}",
+            logger.log(Verbosity::INFO, "Got bus entry: [{:04x}:{:02x}] is root: {}",
                         dom, bus, is_root_bus);
             bus_vt.emplace_back(dom, bus, is_root_bus ? 1 : 0);
         }
@@ -215,20 +215,28 @@ std::vector<DeviceDesc>
 SysfsProvider::GetPCIDevDescriptors()
 {
     std::vector<DeviceDesc> devices;
+    ForEachPCIDevDescriptor([&](DeviceDesc &&dev_desc) {
+        devices.push_back(std::move(dev_desc));
+    });
+    return devices;
+}
 
+void
+SysfsProvider::ForEachPCIDevDescriptor(const std::function<void(DeviceDesc &&)> &visitor)
+{
     logger.log(Verbosity::INFO, "Scanning {}...", pci_devs_path);
 
     for (const auto &pci_dev_dir_e : fs::directory_iterator {pci_devs_path}) {
         uint32_t dom, bus, dev, func;
         auto res = std::sscanf(pci_dev_dir_e.path().filename().c_str(),
-                               "%4u:%2x:%2x.%u", &dom, &bus, &dev, &func);
+                               "%x:%2x:%2x.%x", &dom, &bus, &dev, &func);
         if (res != 4) {
             throw std::runtime_error(std::format("Failed to parse BDF for {}\n",
                                      pci_dev_dir_e.path().string()));
         } else {
-            logger.log(Verbosity::INFO, "Got -> [{:04}:{:02x}:{:02x}.{:x}]", dom, bus, dev, func);
+            logger.log(Verbosity::INFO, "Got -> [{:04x}:{:02x}:{:02x}.{:x}]", dom, bus, dev, func);
 
-            uint64_t d_bdf = func | (dev << 8) | (bus << 16) | (dom << 24);
+            uint64_t d_bdf = func | (dev << 8) | (bus << 16) | (uint64_t{dom} << 24);
             auto [data, cfg_len] = GetCfgSpaceBuf(pci_dev_dir_e.path());
 
             // try to acquire resources
@@ -241,16 +249,28 @@ SysfsProvider::GetPCIDevDescriptors()
             auto numa_node = GetNumaNode(pci_dev_dir_e.path());
             auto iommu_group = GetIommuGroup(pci_dev_dir_e.path());
 
-            devices.emplace_back(d_bdf, cfg_len, std::move(data), std::move(resources),
-                                 driver_name, numa_node, iommu_group, pci_dev_dir_e.path());
+            visitor(DeviceDesc(d_bdf, cfg_len, std::move(data), std::move(resources),
+                               driver_name, numa_node, iommu_group, pci_dev_dir_e.path()));
         }
     }
-    return devices;
 }
 
 void
-SysfsProvider::SaveState([[maybe_unused]]const std::vector<DeviceDesc> &devs,
-                         [[maybe_unused]]const std::vector<BusDesc> &buses)
+SysfsProvider::BeginSaveState()
+{
+    throw std::runtime_error(std::format("{} provider doesn't support state saving",
+                             GetProviderName()));
+}
+
+void
+SysfsProvider::SaveDevice([[maybe_unused]]const DeviceDesc &dev)
+{
+    throw std::runtime_error(std::format("{} provider doesn't support state saving",
+                             GetProviderName()));
+}
+
+void
+SysfsProvider::EndSaveState([[maybe_unused]]const std::vector<BusDesc> &buses)
 {
     throw std::runtime_error(std::format("{} provider doesn't support state saving",
                              GetProviderName()));
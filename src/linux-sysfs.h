@@ -17,11 +17,14 @@ struct SysfsProvider : public Provider
     std::vector<BusDesc>         GetBusDescriptors() override;
     // <dom+BDF, cfg space len, cfg space buf, path to device in sysfs>
     std::vector<DeviceDesc>      GetPCIDevDescriptors() override;
+    void                         ForEachPCIDevDescriptor(
+                                     const std::function<void(DeviceDesc &&)> &visitor) override;
 
     bool                         ShouldParseV2PBarMappingInfo() override { return true; }
 
-    void SaveState(const std::vector<DeviceDesc> &devs,
-                   const std::vector<BusDesc> &buses) override;
+    void BeginSaveState() override;
+    void SaveDevice(const DeviceDesc &dev) override;
+    void EndSaveState(const std::vector<BusDesc> &buses) override;
 };
 
 } // namespace sysfs
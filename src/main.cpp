@@ -12,6 +12,9 @@
 
 #include <ftxui/component/screen_interactive.hpp>
 
+#include <future>
+#include <thread>
+
 cfg::CmdLOpts    cmdline_options;
 cfg::PCIexCfg    pciex_cfg;
 vm::VmallocStats vm_info;
@@ -44,36 +47,95 @@ int main(int argc, char *argv[])
             throw std::runtime_error("Unsupported endianness");
         }
 
-        if (sys::IsKptrSet())
-            vm_info.Parse();
-        else
-            logger.log(Verbosity::WARN, "vmalloced addresses are hidden\n");
-
-        if (vm_info.InfoAvailable())
-            vm_info.DumpStats();
-
         pci::PCITopologyCtx topology(cmdline_options.mode_ == cfg::OperationMode::Live);
         auto [capture_provider, store_provider] = GetProvidersForOpMode(cmdline_options);
 
         if (cmdline_options.mode_ == cfg::OperationMode::SnapshotCapture) {
             topology.Capture(*capture_provider, *store_provider);
         } else {
-            topology.Populate(*capture_provider);
-            topology.DumpData();
-
-            std::unique_ptr<ui::ScreenCompCtx> screen_comp_ctx;
-            ftxui::Component                   main_comp;
-
-            try {
-                screen_comp_ctx.reset(new ui::ScreenCompCtx(topology));
-                main_comp = screen_comp_ctx->Create();
-            } catch (std::exception &ex) {
-                logger.log(Verbosity::FATAL, "Failed to initialize screen components: {}", ex.what());
-                throw;
-            }
+            // /proc/vmallocinfo might be huge, and v2p info is only needed
+            // for BARs detailed info, so don't let it delay the UI startup
+            std::shared_future<void> vm_info_parsed = std::async(std::launch::async, [] {
+                if (sys::IsKptrSet())
+                    vm_info.Parse();
+                else
+                    logger.log(Verbosity::WARN, "vmalloced addresses are hidden\n");
+
+                if (vm_info.InfoAvailable())
+                    vm_info.DumpStats();
+            }).share();
 
             auto screen = ftxui::ScreenInteractive::Fullscreen();
-            screen.Loop(main_comp);
+            ui::ScreenCompCtx screen_comp_ctx(topology);
+
+            // v2p worker posts events to the screen, so it must be finished
+            // before the screen is destroyed, even if the UI loop throws
+            struct V2PWaitGuard
+            {
+                pci::PCITopologyCtx &topo_;
+                ~V2PWaitGuard() { topo_.WaitV2PMappings(); }
+            } v2p_wait_guard {topology};
+
+            // redraw BARs info as soon as v2p mappings are available
+            auto resolve_v2p = [&] {
+                topology.ResolveV2PMappingsAsync(vm_info_parsed, [&screen] {
+                    screen.PostEvent(ftxui::Event::Custom);
+                });
+            };
+
+            // failures of screen components initialization are fatal
+            auto init_comps = [](auto &&init) {
+                try {
+                    return init();
+                } catch (std::exception &ex) {
+                    logger.log(Verbosity::FATAL, "Failed to initialize screen components: {}", ex.what());
+                    throw;
+                }
+            };
+
+            if (pciex_cfg.tui.async_topology_load) {
+                // UI starts right away, the topology is populated in the background.
+                // Decoded devices and all the UI state updates are passed to the
+                // UI thread via Post().
+                auto main_comp = init_comps([&] { return screen_comp_ctx.CreateLoading(); });
+                std::exception_ptr load_err;
+
+                // jthread, so the loader is joined even if the UI loop throws
+                std::jthread loader([&] {
+                    try {
+                        topology.Populate(*capture_provider, [&screen, &screen_comp_ctx](auto devs) {
+                            screen.Post([&screen_comp_ctx, devs = std::vector(devs.begin(), devs.end())] {
+                                screen_comp_ctx.OnLoadProgress(devs);
+                            });
+                            screen.PostEvent(ftxui::Event::Custom);
+                        });
+                        topology.DumpData();
+
+                        screen.Post([&] {
+                            init_comps([&] { screen_comp_ctx.OnTopologyLoaded(); });
+                            resolve_v2p();
+                        });
+                    } catch (...) {
+                        load_err = std::current_exception();
+                        screen.Post(screen.ExitLoopClosure());
+                    }
+                    screen.PostEvent(ftxui::Event::Custom);
+                });
+
+                screen.Loop(main_comp);
+                loader.join();
+
+                if (load_err)
+                    std::rethrow_exception(load_err);
+            } else {
+                topology.Populate(*capture_provider);
+                topology.DumpData();
+
+                auto main_comp = init_comps([&] { return screen_comp_ctx.Create(); });
+                resolve_v2p();
+
+                screen.Loop(main_comp);
+            }
         }
     } catch (std::exception &ex) {
         std::print("[{}] mode failure -> {}\nCheck log for details\n",
@@ -17,114 +17,25 @@ extern vm::VmallocStats vm_info;
 
 namespace pci {
 
-static constexpr CTMap<Type0Cfg, uint32_t, type0_compat_reg_cnt> t0_reg_map {{
-    {{Type0Cfg::vid,             2},
-     {Type0Cfg::dev_id,          2},
-     {Type0Cfg::command,         2},
-     {Type0Cfg::status,          2},
-
-     {Type0Cfg::revision,        1},
-     {Type0Cfg::class_code,      3},
-
-     {Type0Cfg::cache_line_size, 1},
-     {Type0Cfg::latency_timer,   1},
-     {Type0Cfg::header_type,     1},
-     {Type0Cfg::bist,            1},
-
-     {Type0Cfg::bar0,            4},
-     {Type0Cfg::bar1,            4},
-     {Type0Cfg::bar2,            4},
-     {Type0Cfg::bar3,            4},
-     {Type0Cfg::bar4,            4},
-     {Type0Cfg::bar5,            4},
-
-     {Type0Cfg::cardbus_cis_ptr, 4},
-     {Type0Cfg::subsys_vid,      2},
-     {Type0Cfg::subsys_dev_id,   2},
-     {Type0Cfg::exp_rom_bar,     4},
-
-     {Type0Cfg::cap_ptr,         1},
-
-     {Type0Cfg::itr_line,        1},
-     {Type0Cfg::itr_pin,         1},
-
-     {Type0Cfg::min_gnt,         1},
-     {Type0Cfg::max_lat,         1}}
-}};
-
-static constexpr CTMap<Type1Cfg, uint32_t, type1_compat_reg_cnt> t1_reg_map {{
-    {{Type1Cfg::vid,              2},
-     {Type1Cfg::dev_id,           2},
-     {Type1Cfg::command,          2},
-     {Type1Cfg::status,           2},
-
-     {Type1Cfg::revision,         1},
-     {Type1Cfg::class_code,       3},
-
-     {Type1Cfg::cache_line_size,  1},
-     {Type1Cfg::prim_lat_timer,   1},
-     {Type1Cfg::header_type,      1},
-     {Type1Cfg::bist,             1},
-
-     {Type1Cfg::bar0,             4},
-     {Type1Cfg::bar1,             4},
-
-     {Type1Cfg::prim_bus_num,     1},
-     {Type1Cfg::sec_bus_num,      1},
-     {Type1Cfg::sub_bus_num,      1},
-     {Type1Cfg::sec_lat_timer,    1},
-
-     {Type1Cfg::io_base,          1},
-     {Type1Cfg::io_limit,         1},
-     {Type1Cfg::sec_status,       2},
-
-     {Type1Cfg::mem_base,         2},
-     {Type1Cfg::mem_limit,        2},
-
-     {Type1Cfg::pref_mem_base,    2},
-     {Type1Cfg::pref_mem_limit,   2},
-
-     {Type1Cfg::pref_base_upper,  4},
-     {Type1Cfg::pref_limit_upper, 4},
-
-     {Type1Cfg::io_base_upper,    2},
-     {Type1Cfg::io_limit_upper,   2},
-
-     {Type1Cfg::cap_ptr,          1},
-
-     {Type1Cfg::exp_rom_bar,      4},
-
-     {Type1Cfg::itr_line,         1},
-     {Type1Cfg::itr_pin,          1},
-     {Type1Cfg::bridge_ctl,       2}}
-}};
-
 PciDevBase::PciDevBase(uint64_t d_bdf, cfg_space_type cfg_len, pci_dev_type dev_type,
-                       ProviderArg &p_arg, std::unique_ptr<uint8_t []> cfg_buf) :
+                       std::unique_ptr<uint8_t []> cfg_buf) :
     dom_(d_bdf >> 24 & 0xffff),
     bus_(d_bdf >> 16 & 0xff),
     dev_(d_bdf >> 8 & 0xff),
     func_(d_bdf & 0xff),
     dev_id_(d_bdf),
-    ids_names_(IDS_TYPES_CNT),
-    dev_id_str_(std::format("[{:02x}:{:02x}.{:x}]", bus_, dev_, func_)),
     is_pcie_(false),
     cfg_type_(cfg_len),
     type_(dev_type),
     cfg_space_(std::move(cfg_buf)),
-    sys_path_(),
-    cfg_buf_(nullptr),
     compat_caps_num_(0),
     extended_caps_num_(0)
-    {
-        std::visit([&](auto &&varg) {
-            using T = std::decay_t<decltype(varg)>;
-            if constexpr (std::is_same_v<T, fs::path>)
-                sys_path_ = varg;
-            else if constexpr (std::is_same_v<T, OpaqueBuf>)
-                cfg_buf_ = std::move(varg);
-        }, p_arg);
-    }
+    {}
+
+std::string PciDevBase::DevIdStr() const
+{
+    return std::format("[{:02x}:{:02x}.{:x}]", bus_, dev_, func_);
+}
 
 void PciDevBase::ParseCapabilities()
 {
@@ -144,7 +55,7 @@ void PciDevBase::ParseCapabilities()
             if (cap_type == CompatCapID::pci_express)
                 is_pcie_ = true;
 
-            caps_.emplace_back(CapType::compat, compat_cap->cap_id, 0, next_cap_off);
+            caps_.emplace_back(compat_cap->cap_id, 0, next_cap_off);
             compat_caps_num_++;
             next_cap_off = compat_cap->next_cap;
     }
@@ -156,8 +67,7 @@ void PciDevBase::ParseCapabilities()
                            (cfg_space_.get() + next_cap_off);
             auto cap_type = ExtCapID{ext_cap->cap_id};
             if (cap_type != ExtCapID::null_cap) {
-                caps_.emplace_back(CapType::extended, ext_cap->cap_id, ext_cap->cap_ver,
-                                   next_cap_off);
+                caps_.emplace_back(ext_cap->cap_id, ext_cap->cap_ver, next_cap_off);
                 extended_caps_num_++;
             }
             next_cap_off = ext_cap->next_cap;
@@ -165,6 +75,28 @@ void PciDevBase::ParseCapabilities()
     }
 
     assert(caps_.size() != 0);
+
+    // Build capability index. Instances of the same capability are linked
+    // in the order of capability lists.
+    caps_next_.assign(caps_.size(), 0);
+    std::array<uint16_t, compat_cap_id_cnt> compat_last {};
+    std::array<uint16_t, ext_cap_id_cnt>    ext_last {};
+
+    for (uint16_t i = 0; i < caps_.size(); i++) {
+        const auto &cap = caps_[i];
+        auto is_compat = cap.type() == CapType::compat;
+        auto tbl_size = is_compat ? compat_cap_id_cnt : ext_cap_id_cnt;
+        if (cap.id() >= tbl_size)
+            continue;
+
+        auto &first = is_compat ? compat_cap_idx_[cap.id()] : ext_cap_idx_[cap.id()];
+        auto &last  = is_compat ? compat_last[cap.id()] : ext_last[cap.id()];
+        if (first == 0)
+            first = i + 1;
+        else
+            caps_next_[last - 1] = i + 1;
+        last = i + 1;
+    }
 }
 
 void PciDevBase::DumpCapabilities() noexcept
@@ -172,44 +104,44 @@ void PciDevBase::DumpCapabilities() noexcept
     logger.log(Verbosity::INFO, "[{:02x}:{:02x}.{:x}]: {} capabilities >>>",
                bus_, dev_, func_, caps_.size());
     for (size_t i = 0; auto &cap : caps_) {
-        auto cap_type = std::get<0>(cap);
+        auto cap_type = cap.type();
 
         if (cap_type == CapType::compat) {
-            auto compat_cap_type = CompatCapID{std::get<1>(cap)};
-            logger.log(Verbosity::RAW, "[#{:2} {:#03x}] -> '{}'", i++, std::get<3>(cap),
+            auto compat_cap_type = CompatCapID{cap.id()};
+            logger.log(Verbosity::RAW, "[#{:2} {:#03x}] -> '{}'", i++, cap.off(),
                        CompatCapName(compat_cap_type));
         } else {
-            auto ext_cap_type = ExtCapID{std::get<1>(cap)};
-            logger.log(Verbosity::RAW, "[#{:2} {:#03x}] -> (EXT, ver {}) '{}'", i++, std::get<3>(cap),
-                       std::get<2>(cap), ExtCapName(ext_cap_type));
+            auto ext_cap_type = ExtCapID{cap.id()};
+            logger.log(Verbosity::RAW, "[#{:2} {:#03x}] -> (EXT, ver {}) '{}'", i++, cap.off(),
+                       cap.ver(), ExtCapName(ext_cap_type));
         }
     }
 }
 
 uint16_t PciDevBase::GetCapOffByID(const CapType cap_type, const uint16_t cap_id) const
 {
-    if (caps_.empty())
+    if (GetCaps().empty())
         return 0;
 
+    auto pos = GetCapIdxPos(cap_type, cap_id);
+    if (pos != nullptr)
+        return *pos != 0 ? caps_[*pos - 1].off() : 0;
+
+    // capability ID unknown to the index
     for (const auto &cap : caps_)
-        if (std::get<0>(cap) == cap_type && std::get<1>(cap) == cap_id)
-            return std::get<3>(cap);
+        if (cap.type() == cap_type && cap.id() == cap_id)
+            return cap.off();
 
     return 0;
 }
 
 
 
-void PciDevBase::AssignResources(std::vector<DevResourceDesc> resources) noexcept
-{
-    resources_ = std::move(resources);
-}
-
-void PciDevBase::DumpResources() noexcept
+void PciDevBase::DumpResources(const std::vector<DevResourceDesc> &resources) const noexcept
 {
     logger.log(Verbosity::INFO, "{} -> dump resources ({}): >>>",
-               dev_id_str_, resources_.size());
-    for (int i = 0; const auto &res_entry : resources_) {
+               DevIdStr(), resources.size());
+    for (int i = 0; const auto &res_entry : resources) {
         logger.log(Verbosity::RAW,
                    "[{:2}] {:#016x} {:#016x} {:#016x}", i++, std::get<0>(res_entry),
                    std::get<1>(res_entry), std::get<2>(res_entry));
@@ -217,53 +149,90 @@ void PciDevBase::DumpResources() noexcept
 
 }
 
-void PciDevBase::ParseBars() noexcept
+// Only non-empty BARs and expansion ROM resources are kept,
+// raw resources descriptors are not needed afterwards
+void PciDevBase::ParseBars(const std::vector<DevResourceDesc> &resources)
 {
-    auto num_bars = (type_ == pci_dev_type::TYPE0) ? 6 : 2;
-    for (int i = 0; i < num_bars; i++) {
-        auto [start, end, flags] = resources_[i];
+    uint32_t num_bars = (type_ == pci_dev_type::TYPE0) ? 6 : 2;
+    auto res_cnt = std::min<size_t>(resources.size(), dev_exp_rom_res_idx + 1);
 
+    for (uint32_t i = 0; i < res_cnt; i++) {
+        if (i >= num_bars && i != dev_exp_rom_res_idx)
+            continue;
+
+        auto [start, end, flags] = resources[i];
         if (flags == 0) {
             assert(start == 0 && end == 0);
-
-            bar_res_[i].type_ = ResourceType::EMPTY;
             continue;
-        } else {
-            if (flags & PCIResIO)
-                bar_res_[i].type_ = ResourceType::IO;
-            if (flags & PCIResMEM)
-                bar_res_[i].type_ = ResourceType::MEMORY;
+        }
 
-            if (flags & PCIResPrefetch)
-                bar_res_[i].is_prefetchable_ = true;
+        PciDevBarResource bar_res(i);
+        if (flags & PCIResIO)
+            bar_res.type_ = ResourceType::IO;
+        if (flags & PCIResMEM)
+            bar_res.type_ = ResourceType::MEMORY;
 
-            if (flags & PCIResMem64)
-                bar_res_[i].is_64bit_ = true;
-        }
+        if (flags & PCIResPrefetch)
+            bar_res.is_prefetchable_ = true;
 
-        bar_res_[i].phys_addr_ = start;
-        bar_res_[i].len_ = end - start + 1;
+        if (flags & PCIResMem64)
+            bar_res.is_64bit_ = true;
+
+        bar_res.phys_addr_ = start;
+        bar_res.len_ = end - start + 1;
+        bar_res_.push_back(bar_res);
     }
+
+    bar_res_.shrink_to_fit();
+}
+
+const PciDevBarResource &PciDevBase::GetBarRes(const uint32_t idx) const noexcept
+{
+    static const PciDevBarResource empty_res;
+
+    for (const auto &bar_res : bar_res_)
+        if (bar_res.idx_ == idx)
+            return bar_res;
+
+    return empty_res;
+}
+
+size_t PciDevBase::MemUsage() const noexcept
+{
+    size_t obj_size = (type_ == pci_dev_type::TYPE0) ? sizeof(PciType0Dev) :
+                                                       sizeof(PciType1Dev);
+    return obj_size + e_to_type(cfg_type_) +
+           caps_.capacity() * sizeof(CapDesc) +
+           caps_next_.capacity() * sizeof(uint16_t) +
+           bar_res_.capacity() * sizeof(PciDevBarResource) +
+           v2p_map_info_.capacity() * sizeof(vm::VmallocEntry);
 }
 
 void PciDevBase::ParseBarsV2PMappings()
 {
     if (vm_info.InfoAvailable()) {
-        auto num_bars = (type_ == pci_dev_type::TYPE0) ? 6 : 2;
-        for (int i = 0; i < num_bars; i++) {
-            auto &cur_bar_res = bar_res_[i];
-            if (cur_bar_res.type_ == ResourceType::MEMORY) {
-                auto pa_start = cur_bar_res.phys_addr_;
-                auto pa_end = cur_bar_res.phys_addr_ + cur_bar_res.len_;
-                auto va2pa_info = vm_info.GetMappingInRange(pa_start, pa_end);
-
-                if (!va2pa_info.empty()) {
-                    cur_bar_res.has_v2p_info_ = true;
-                    v2p_bar_map_info_[i] = std::move(va2pa_info);
-                }
-            }
+        for (auto &cur_bar_res : bar_res_) {
+            if (cur_bar_res.idx_ >= dev_max_bar_cnt ||
+                cur_bar_res.type_ != ResourceType::MEMORY)
+                continue;
+
+            auto pa_start = cur_bar_res.phys_addr_;
+            auto pa_end = cur_bar_res.phys_addr_ + cur_bar_res.len_;
+            auto first = v2p_map_info_.size();
+
+            vm_info.ForEachMappingInRange(pa_start, pa_end, [&](const auto &vm_e) {
+                if (v2p_map_info_.size() < UINT16_MAX)
+                    v2p_map_info_.push_back(vm_e);
+            });
+
+            cur_bar_res.v2p_first_ = first;
+            cur_bar_res.v2p_cnt_ = v2p_map_info_.size() - first;
         }
+        v2p_map_info_.shrink_to_fit();
     }
+
+    // publish v2p info to UI thread
+    v2p_state_.store(V2PInfoState::READY, std::memory_order_release);
 }
 
 void PciDevBase::ParseIDs(PciIdParser &parser)
@@ -282,67 +251,67 @@ void PciDevBase::ParseIDs(PciIdParser &parser)
 
 uint32_t PciDevBase::get_vendor_id() const noexcept
 {
-    return get_reg_compat(Type0Cfg::vid, t0_reg_map);
+    return get_reg<Type0Cfg::vid>();
 }
 
 uint32_t PciDevBase::get_device_id() const noexcept
 {
-    return get_reg_compat(Type0Cfg::dev_id, t0_reg_map);
+    return get_reg<Type0Cfg::dev_id>();
 }
 
 uint32_t PciDevBase::get_command() const noexcept
 {
-    return get_reg_compat(Type0Cfg::command, t0_reg_map);
+    return get_reg<Type0Cfg::command>();
 }
 
 uint32_t PciDevBase::get_status() const noexcept
 {
-    return get_reg_compat(Type0Cfg::status, t0_reg_map);
+    return get_reg<Type0Cfg::status>();
 }
 
 uint32_t PciDevBase::get_rev_id() const noexcept
 {
-    return get_reg_compat(Type0Cfg::revision, t0_reg_map);
+    return get_reg<Type0Cfg::revision>();
 }
 
 uint32_t PciDevBase::get_class_code() const noexcept
 {
-    return get_reg_compat(Type0Cfg::class_code, t0_reg_map);
+    return get_reg<Type0Cfg::class_code>();
 }
 
 uint32_t PciDevBase::get_cache_line_size() const noexcept
 {
-    return get_reg_compat(Type0Cfg::cache_line_size, t0_reg_map);
+    return get_reg<Type0Cfg::cache_line_size>();
 }
 
 uint32_t PciDevBase::get_lat_timer() const noexcept
 {
-    return get_reg_compat(Type0Cfg::latency_timer, t0_reg_map);
+    return get_reg<Type0Cfg::latency_timer>();
 }
 
 uint32_t PciDevBase::get_header_type() const noexcept
 {
-    return get_reg_compat(Type0Cfg::header_type, t0_reg_map);
+    return get_reg<Type0Cfg::header_type>();
 }
 
 uint32_t PciDevBase::get_bist() const noexcept
 {
-    return get_reg_compat(Type0Cfg::bist, t0_reg_map);
+    return get_reg<Type0Cfg::bist>();
 }
 
 uint32_t PciDevBase::get_cap_ptr() const noexcept
 {
-    return get_reg_compat(Type0Cfg::cap_ptr, t0_reg_map);
+    return get_reg<Type0Cfg::cap_ptr>();
 }
 
 uint32_t PciDevBase::get_itr_line() const noexcept
 {
-    return get_reg_compat(Type0Cfg::itr_line, t0_reg_map);
+    return get_reg<Type0Cfg::itr_line>();
 }
 
 uint32_t PciDevBase::get_itr_pin() const noexcept
 {
-    return get_reg_compat(Type0Cfg::itr_pin, t0_reg_map);
+    return get_reg<Type0Cfg::itr_pin>();
 }
 
 //
@@ -351,62 +320,62 @@ uint32_t PciDevBase::get_itr_pin() const noexcept
 
 uint32_t PciType0Dev::get_bar0() const noexcept
 {
-    return get_reg_compat(Type0Cfg::bar0, t0_reg_map);
+    return get_reg<Type0Cfg::bar0>();
 }
 
 uint32_t PciType0Dev::get_bar1() const noexcept
 {
-    return get_reg_compat(Type0Cfg::bar1, t0_reg_map);
+    return get_reg<Type0Cfg::bar1>();
 }
 
 uint32_t PciType0Dev::get_bar2() const noexcept
 {
-    return get_reg_compat(Type0Cfg::bar2, t0_reg_map);
+    return get_reg<Type0Cfg::bar2>();
 }
 
 uint32_t PciType0Dev::get_bar3() const noexcept
 {
-    return get_reg_compat(Type0Cfg::bar3, t0_reg_map);
+    return get_reg<Type0Cfg::bar3>();
 }
 
 uint32_t PciType0Dev::get_bar4() const noexcept
 {
-    return get_reg_compat(Type0Cfg::bar4, t0_reg_map);
+    return get_reg<Type0Cfg::bar4>();
 }
 
 uint32_t PciType0Dev::get_bar5() const noexcept
 {
-    return get_reg_compat(Type0Cfg::bar5, t0_reg_map);
+    return get_reg<Type0Cfg::bar5>();
 }
 
 uint32_t PciType0Dev::get_cardbus_cis() const noexcept
 {
-    return get_reg_compat(Type0Cfg::cardbus_cis_ptr, t0_reg_map);
+    return get_reg<Type0Cfg::cardbus_cis_ptr>();
 }
 
 uint32_t PciType0Dev::get_subsys_vid() const noexcept
 {
-    return get_reg_compat(Type0Cfg::subsys_vid, t0_reg_map);
+    return get_reg<Type0Cfg::subsys_vid>();
 }
 
 uint32_t PciType0Dev::get_subsys_dev_id() const noexcept
 {
-    return get_reg_compat(Type0Cfg::subsys_dev_id, t0_reg_map);
+    return get_reg<Type0Cfg::subsys_dev_id>();
 }
 
 uint32_t PciType0Dev::get_exp_rom_bar() const noexcept
 {
-    return get_reg_compat(Type0Cfg::exp_rom_bar, t0_reg_map);
+    return get_reg<Type0Cfg::exp_rom_bar>();
 }
 
 uint32_t PciType0Dev::get_min_gnt() const noexcept
 {
-    return get_reg_compat(Type0Cfg::min_gnt, t0_reg_map);
+    return get_reg<Type0Cfg::min_gnt>();
 }
 
 uint32_t PciType0Dev::get_max_lat() const noexcept
 {
-    return get_reg_compat(Type0Cfg::max_lat, t0_reg_map);
+    return get_reg<Type0Cfg::max_lat>();
 }
 
 void PciType0Dev::ParseIDs(PciIdParser &parser)
@@ -429,7 +398,7 @@ void PciType0Dev::ParseIDs(PciIdParser &parser)
 void PciType0Dev::print_data() const noexcept {
     auto vid    = get_vendor_id();
     auto dev_id = get_device_id();
-    logger.log(Verbosity::INFO, "[{:04}:{:02x}:{:02x}.{:x}] -> TYPE 0: cfg_size {:4} vendor {:2x} | dev {:2x}",
+    logger.log(Verbosity::INFO, "[{:04x}:{:02x}:{:02x}.{:x}] -> TYPE 0: cfg_size {:4} vendor {:2x} | dev {:2x}",
                dom_, bus_, dev_, func_, e_to_type(cfg_type_), vid, dev_id);
 }
 
@@ -439,100 +408,100 @@ void PciType0Dev::print_data() const noexcept {
 
 uint32_t PciType1Dev::get_bar0() const noexcept
 {
-    return get_reg_compat(Type1Cfg::bar0, t1_reg_map);
+    return get_reg<Type1Cfg::bar0>();
 }
 
 uint32_t PciType1Dev::get_bar1() const noexcept
 {
-    return get_reg_compat(Type1Cfg::bar1, t1_reg_map);
+    return get_reg<Type1Cfg::bar1>();
 }
 uint32_t PciType1Dev::get_prim_bus_num() const noexcept
 {
-    return get_reg_compat(Type1Cfg::prim_bus_num, t1_reg_map);
+    return get_reg<Type1Cfg::prim_bus_num>();
 }
 uint32_t PciType1Dev::get_sec_bus_num() const noexcept
 {
-    return get_reg_compat(Type1Cfg::sec_bus_num, t1_reg_map);
+    return get_reg<Type1Cfg::sec_bus_num>();
 }
 uint32_t PciType1Dev::get_sub_bus_num() const noexcept
 {
-    return get_reg_compat(Type1Cfg::sub_bus_num, t1_reg_map);
+    return get_reg<Type1Cfg::sub_bus_num>();
 }
 uint32_t PciType1Dev::get_sec_lat_timer() const noexcept
 {
-    return get_reg_compat(Type1Cfg::sec_lat_timer, t1_reg_map);
+    return get_reg<Type1Cfg::sec_lat_timer>();
 }
 
 uint32_t PciType1Dev::get_io_base() const noexcept
 {
-    return get_reg_compat(Type1Cfg::io_base, t1_reg_map);
+    return get_reg<Type1Cfg::io_base>();
 }
 
 uint32_t PciType1Dev::get_io_limit() const noexcept
 {
-    return get_reg_compat(Type1Cfg::io_limit, t1_reg_map);
+    return get_reg<Type1Cfg::io_limit>();
 }
 
 uint32_t PciType1Dev::get_sec_status() const noexcept
 {
-    return get_reg_compat(Type1Cfg::sec_status, t1_reg_map);
+    return get_reg<Type1Cfg::sec_status>();
 }
 
 uint32_t PciType1Dev::get_mem_base() const noexcept
 {
-    return get_reg_compat(Type1Cfg::mem_base, t1_reg_map);
+    return get_reg<Type1Cfg::mem_base>();
 }
 
 uint32_t PciType1Dev::get_mem_limit() const noexcept
 {
-    return get_reg_compat(Type1Cfg::mem_limit, t1_reg_map);
+    return get_reg<Type1Cfg::mem_limit>();
 }
 
 uint32_t PciType1Dev::get_pref_mem_base() const noexcept
 {
-    return get_reg_compat(Type1Cfg::pref_mem_base, t1_reg_map);
+    return get_reg<Type1Cfg::pref_mem_base>();
 }
 
 uint32_t PciType1Dev::get_pref_mem_limit() const noexcept
 {
-    return get_reg_compat(Type1Cfg::pref_mem_limit, t1_reg_map);
+    return get_reg<Type1Cfg::pref_mem_limit>();
 }
 
 uint32_t PciType1Dev::get_pref_base_upper() const noexcept
 {
-    return get_reg_compat(Type1Cfg::pref_base_upper, t1_reg_map);
+    return get_reg<Type1Cfg::pref_base_upper>();
 }
 
 uint32_t PciType1Dev::get_pref_limit_upper() const noexcept
 {
-    return get_reg_compat(Type1Cfg::pref_limit_upper, t1_reg_map);
+    return get_reg<Type1Cfg::pref_limit_upper>();
 }
 
 uint32_t PciType1Dev::get_io_base_upper() const noexcept
 {
-    return get_reg_compat(Type1Cfg::io_base_upper, t1_reg_map);
+    return get_reg<Type1Cfg::io_base_upper>();
 }
 
 uint32_t PciType1Dev::get_io_limit_upper() const noexcept
 {
-    return get_reg_compat(Type1Cfg::io_limit_upper, t1_reg_map);
+    return get_reg<Type1Cfg::io_limit_upper>();
 }
 
 uint32_t PciType1Dev::get_exp_rom_bar() const noexcept
 {
-    return get_reg_compat(Type1Cfg::exp_rom_bar, t1_reg_map);
+    return get_reg<Type1Cfg::exp_rom_bar>();
 }
 
 uint32_t PciType1Dev::get_bridge_ctl() const noexcept
 {
-    return get_reg_compat(Type1Cfg::bridge_ctl, t1_reg_map);
+    return get_reg<Type1Cfg::bridge_ctl>();
 }
 
 void PciType1Dev::print_data() const noexcept {
     auto dev_id = get_device_id();
-    auto vid = *reinterpret_cast<uint16_t *>(cfg_space_.get() + e_to_type(Type1Cfg::vid));
+    auto vid = get_reg<Type1Cfg::vid>();
     logger.log(Verbosity::INFO,
-               "[{:04}:{:02x}:{:02x}.{:x}] -> TYPE 1: cfg_size {:4} vendor {:2x} | dev {:2x}",
+               "[{:04x}:{:02x}:{:02x}.{:x}] -> TYPE 1: cfg_size {:4} vendor {:2x} | dev {:2x}",
                dom_, bus_, dev_, func_, e_to_type(cfg_type_), vid, dev_id);
 }
 
@@ -3,14 +3,20 @@
 
 #pragma once
 
+#include <atomic>
 #include <string>
 #include <string_view>
 #include <vector>
 #include <cstdint>
 #include <filesystem>
 #include <array>
+#include <cassert>
+#include <cstring>
+#include <mutex>
+#include <span>
 
 #include "ids_parse.h"
+#include "pci_regs.h"
 #include "provider_iface.h"
 #include "util.h"
 
@@ -59,10 +65,34 @@ constexpr uint32_t      PCIResMEM = 0x200;
 constexpr uint32_t PCIResPrefetch = 0x2000;
 constexpr uint32_t    PCIResMem64 = 0x100000;
 
-// <cap type: compat or ext, capability ID, version, offset within config space>
-typedef std::tuple<CapType, uint16_t, uint8_t, uint16_t> CapDesc;
+// Capability descriptor: capability ID, version and offset within config space.
+// Extended capabilities always reside above compatible config space,
+// so the type is derived from the offset.
+struct CapDesc
+{
+    uint16_t id_;
+    uint16_t ver_ : 4;
+    uint16_t off_ : 12;
+
+    CapDesc(const uint16_t id, const uint8_t ver, const uint16_t off) :
+        id_(id), ver_(ver & 0xf), off_(off & 0xfff)
+    {  }
 
-enum class ResourceType
+    CapType  type() const noexcept
+    {
+        return off_ >= ext_cap_cfg_off ? CapType::extended : CapType::compat;
+    }
+    uint16_t id()  const noexcept { return id_; }
+    uint8_t  ver() const noexcept { return ver_; }
+    uint16_t off() const noexcept { return off_; }
+};
+static_assert(sizeof(CapDesc) == 4);
+
+// Number of known capability IDs, i.e. size of per device capability index tables
+constexpr size_t compat_cap_id_cnt = e_to_type(CompatCapID::flat_portal_brd) + 1;
+constexpr size_t ext_cap_id_cnt    = e_to_type(ExtCapID::sfi) + 1;
+
+enum class ResourceType : uint8_t
 {
     MEMORY,
     IO,
@@ -71,24 +101,174 @@ enum class ResourceType
 
 struct PciDevBarResource
 {
-    ResourceType type_;
     uint64_t     phys_addr_;
     uint64_t     len_;
+    // v2p mapping descriptors range within device v2p info
+    uint16_t     v2p_first_;
+    uint16_t     v2p_cnt_;
+    ResourceType type_;
+    uint8_t      idx_;
     bool         is_64bit_;
     bool         is_prefetchable_;
-    bool         has_v2p_info_;
 
-    PciDevBarResource() :
-        type_(ResourceType::EMPTY),
+    PciDevBarResource(const uint8_t idx = 0) :
         phys_addr_(0),
         len_(0),
+        v2p_first_(0),
+        v2p_cnt_(0),
+        type_(ResourceType::EMPTY),
+        idx_(idx),
         is_64bit_(false),
-        is_prefetchable_(false),
-        has_v2p_info_(false)
+        is_prefetchable_(false)
     {  }
 };
+static_assert(sizeof(PciDevBarResource) == 24);
 
 constexpr uint32_t dev_max_bar_cnt = 6;
+// index of expansion ROM within device resources
+constexpr uint32_t dev_exp_rom_res_idx = 6;
+
+// Width in bytes of compatible configuration header registers
+constexpr CTMap<Type0Cfg, uint32_t, type0_compat_reg_cnt> t0_reg_map {{
+    {{Type0Cfg::vid,             2},
+     {Type0Cfg::dev_id,          2},
+     {Type0Cfg::command,         2},
+     {Type0Cfg::status,          2},
+
+     {Type0Cfg::revision,        1},
+     {Type0Cfg::class_code,      3},
+
+     {Type0Cfg::cache_line_size, 1},
+     {Type0Cfg::latency_timer,   1},
+     {Type0Cfg::header_type,     1},
+     {Type0Cfg::bist,            1},
+
+     {Type0Cfg::bar0,            4},
+     {Type0Cfg::bar1,            4},
+     {Type0Cfg::bar2,            4},
+     {Type0Cfg::bar3,            4},
+     {Type0Cfg::bar4,            4},
+     {Type0Cfg::bar5,            4},
+
+     {Type0Cfg::cardbus_cis_ptr, 4},
+     {Type0Cfg::subsys_vid,      2},
+     {Type0Cfg::subsys_dev_id,   2},
+     {Type0Cfg::exp_rom_bar,     4},
+
+     {Type0Cfg::cap_ptr,         1},
+
+     {Type0Cfg::itr_line,        1},
+     {Type0Cfg::itr_pin,         1},
+
+     {Type0Cfg::min_gnt,         1},
+     {Type0Cfg::max_lat,         1}}
+}};
+
+constexpr CTMap<Type1Cfg, uint32_t, type1_compat_reg_cnt> t1_reg_map {{
+    {{Type1Cfg::vid,              2},
+     {Type1Cfg::dev_id,           2},
+     {Type1Cfg::command,          2},
+     {Type1Cfg::status,           2},
+
+     {Type1Cfg::revision,         1},
+     {Type1Cfg::class_code,       3},
+
+     {Type1Cfg::cache_line_size,  1},
+     {Type1Cfg::prim_lat_timer,   1},
+     {Type1Cfg::header_type,      1},
+     {Type1Cfg::bist,             1},
+
+     {Type1Cfg::bar0,             4},
+     {Type1Cfg::bar1,             4},
+
+     {Type1Cfg::prim_bus_num,     1},
+     {Type1Cfg::sec_bus_num,      1},
+     {Type1Cfg::sub_bus_num,      1},
+     {Type1Cfg::sec_lat_timer,    1},
+
+     {Type1Cfg::io_base,          1},
+     {Type1Cfg::io_limit,         1},
+     {Type1Cfg::sec_status,       2},
+
+     {Type1Cfg::mem_base,         2},
+     {Type1Cfg::mem_limit,        2},
+
+     {Type1Cfg::pref_mem_base,    2},
+     {Type1Cfg::pref_mem_limit,   2},
+
+     {Type1Cfg::pref_base_upper,  4},
+     {Type1Cfg::pref_limit_upper, 4},
+
+     {Type1Cfg::io_base_upper,    2},
+     {Type1Cfg::io_limit_upper,   2},
+
+     {Type1Cfg::cap_ptr,          1},
+
+     {Type1Cfg::exp_rom_bar,      4},
+
+     {Type1Cfg::itr_line,         1},
+     {Type1Cfg::itr_pin,          1},
+     {Type1Cfg::bridge_ctl,       2}}
+}};
+
+// Check that every register of the header is described exactly once,
+// fits into a single dword and doesn't overlap with the others
+template <typename E, size_t N>
+consteval bool RegMapIsValid(const CTMap<E, uint32_t, N> &map)
+{
+    uint64_t used_bytes = 0;
+    for (const auto &[reg, width] : map.arr_) {
+        auto off = e_to_type(reg);
+        if (width == 0 || width > 4 || off % 4 + width > 4 || off + width > 64)
+            return false;
+
+        auto reg_bytes = ((uint64_t{1} << width) - 1) << off;
+        if (used_bytes & reg_bytes)
+            return false;
+        used_bytes |= reg_bytes;
+    }
+    return true;
+}
+
+static_assert(RegMapIsValid(t0_reg_map), "Type 0 header registers map is incomplete");
+static_assert(RegMapIsValid(t1_reg_map), "Type 1 header registers map is incomplete");
+
+template <typename E>
+struct CompatRegMap;
+
+template <>
+struct CompatRegMap<Type0Cfg>
+{
+    static constexpr const auto &map_ = t0_reg_map;
+};
+
+template <>
+struct CompatRegMap<Type1Cfg>
+{
+    static constexpr const auto &map_ = t1_reg_map;
+};
+
+// Compile-time layout of compatible configuration header register
+template <auto Reg>
+struct CompatRegLayout
+{
+    static constexpr uint32_t off_       = e_to_type(Reg);
+    static constexpr uint32_t dword_off_ = off_ & ~3u;
+    static constexpr uint32_t width_     = CompatRegMap<decltype(Reg)>::map_.at(Reg);
+    static constexpr uint32_t shift_     = (off_ % 4) * 8;
+    static constexpr uint32_t mask_      = width_ == 4 ? 0xffffffff :
+                                                         (1u << width_ * 8) - 1;
+
+    static_assert(off_ % 4 + width_ <= 4, "Register must not cross dword boundary");
+};
+
+// State of BARs v2p mapping info, which is resolved in the background
+enum class V2PInfoState : uint8_t
+{
+    NONE,    // not available, e.g. in snapshot mode
+    PENDING,
+    READY
+};
 
 namespace fs = std::filesystem;
 
@@ -99,68 +279,165 @@ struct PciDevBase
     uint8_t         dev_;
     uint8_t         func_;
 
-    // DBDF
+    // DBDF: func | dev << 8 | bus << 16 | dom << 24,
+    // also serves as the canonical device ordering key
     uint64_t        dev_id_;
 
-    std::vector<std::string_view> ids_names_;
+    // index within topology devices array
+    uint32_t        topo_idx_ {0};
 
-    std::string     dev_id_str_;
+    std::array<std::string_view, IDS_TYPES_CNT> ids_names_ {};
 
     bool            is_pcie_;
     cfg_space_type  cfg_type_;
     pci_dev_type    type_;
 
-    OpaqueBuf       cfg_space_;
-
-    // sysfs device path
-    fs::path        sys_path_;
+    // Capabilities are decoded on first access only (see EnsureCapsDecoded()),
+    // so topology-only users never pay for walking the capability lists.
+    // NOTE: @is_pcie_ and capability fields below must not be accessed
+    // directly before that.
+    mutable std::once_flag caps_decoded_;
 
-    OpaqueBuf       cfg_buf_;
+    OpaqueBuf       cfg_space_;
 
-    // Array of capabity descriptors
-    // <cap type: compat or ext, capability ID, version, offset within config space>
+    // Array of capabity descriptors in the order of capability lists
     std::vector<CapDesc> caps_;
     uint8_t compat_caps_num_;
     uint8_t extended_caps_num_;
 
-    // device resources info obtained via sysfs
-    std::vector<DevResourceDesc> resources_;
+    // Capability index: position + 1 within @caps_ of the first capability
+    // instance with a given ID, zero if there is no such capability.
+    // @caps_next_ links multiple instances (e.g. vendor specific or DVSEC)
+    // of the same capability in the same way.
+    std::array<uint16_t, compat_cap_id_cnt> compat_cap_idx_ {};
+    std::array<uint16_t, ext_cap_id_cnt>    ext_cap_idx_ {};
+    std::vector<uint16_t>                   caps_next_;
 
-    // BARs resources
-    std::array<PciDevBarResource, dev_max_bar_cnt> bar_res_;
+    // Non-empty BARs and expansion ROM resources, ordered by index.
+    // Devices without any resources (e.g. some VFs) don't allocate anything.
+    std::vector<PciDevBarResource> bar_res_;
 
-    // v2p mapping descriptors
-    std::array<std::vector<vm::VmallocEntry>, dev_max_bar_cnt> v2p_bar_map_info_;
+    // v2p mapping descriptors of all BARs, see PciDevBarResource::v2p_first_
+    // NOTE: must not be accessed until @v2p_state_ is READY
+    std::vector<vm::VmallocEntry> v2p_map_info_;
+    std::atomic<V2PInfoState> v2p_state_ {V2PInfoState::NONE};
 
     PciDevBase() = delete;
     PciDevBase(uint64_t d_bdf, cfg_space_type cfg_len, pci_dev_type dev_type,
-               ProviderArg &p_arg, std::unique_ptr<uint8_t []> cfg_buf);
+               std::unique_ptr<uint8_t []> cfg_buf);
 
-    template <typename E>
-    constexpr uint32_t get_reg_compat(E e, auto &map) const noexcept
+    // Device ID string, i.e. "[bus:dev.func]"
+    std::string DevIdStr() const;
+
+    // Load a value of type T at @off within config space.
+    // Config space buffer has no alignment guarantees, so copy it out
+    template <typename T>
+    T load_cfg(const uint32_t off) const noexcept
     {
-        auto dword_num = e_to_type(e) / 4;
-        auto dword_off = e_to_type(e) % 4;
-        auto reg_len = map.at(e);
+        assert(cfg_space_ != nullptr && off + sizeof(T) <= static_cast<size_t>(e_to_type(cfg_type_)));
+
+        T val;
+        std::memcpy(&val, cfg_space_.get() + off, sizeof(T));
+        return val;
+    }
 
-        auto dword = *reinterpret_cast<uint32_t *>(cfg_space_.get() + dword_num * 4);
-        if (reg_len == 4)
-            return dword;
+    // Get compatible configuration header register value,
+    // i.e. get_reg<Type0Cfg::vid>()
+    template <auto Reg>
+    uint32_t get_reg() const noexcept
+    {
+        using layout = CompatRegLayout<Reg>;
 
-        dword >>= dword_off * 8;
-        return dword & ((1 << reg_len * 8) - 1);
+        auto dword = load_cfg<uint32_t>(layout::dword_off_);
+        return (dword >> layout::shift_) & layout::mask_;
     }
 
     void ParseCapabilities();
     void DumpCapabilities() noexcept;
 
+    // Decode capabilities once, safe to be called concurrently
+    void EnsureCapsDecoded() const
+    {
+        std::call_once(caps_decoded_, [this] {
+            // device objects are never const-constructed, see PciDevArena
+            auto self = const_cast<PciDevBase *>(this);
+            self->ParseCapabilities();
+            self->DumpCapabilities();
+        });
+    }
+
+    const std::vector<CapDesc> &GetCaps() const
+    {
+        EnsureCapsDecoded();
+        return caps_;
+    }
+
+    uint8_t GetCapsNum(const CapType cap_type) const
+    {
+        EnsureCapsDecoded();
+        return cap_type == CapType::compat ? compat_caps_num_ : extended_caps_num_;
+    }
+
+    bool IsPCIe() const
+    {
+        EnsureCapsDecoded();
+        return is_pcie_;
+    }
+
     // Return an offset within config space where a capability
     // with a given type and ID is located
     uint16_t GetCapOffByID(const CapType cap_type, const uint16_t cap_id) const;
-    void AssignResources(std::vector<DevResourceDesc>) noexcept;
-    void DumpResources() noexcept;
-    void ParseBars() noexcept;
+
+    // Call @func for every instance of a capability with a given type and ID
+    template <typename F>
+    void ForEachCapByID(const CapType cap_type, const uint16_t cap_id, F &&func) const
+    {
+        EnsureCapsDecoded();
+
+        auto pos = GetCapIdxPos(cap_type, cap_id);
+        if (pos == nullptr) {
+            // capability ID unknown to the index
+            for (const auto &cap : caps_)
+                if (cap.type() == cap_type && cap.id() == cap_id)
+                    func(cap);
+            return;
+        }
+
+        for (auto idx = *pos; idx != 0; idx = caps_next_[idx - 1])
+            func(caps_[idx - 1]);
+    }
+    void DumpResources(const std::vector<DevResourceDesc> &resources) const noexcept;
+    void ParseBars(const std::vector<DevResourceDesc> &resources);
     void ParseBarsV2PMappings();
+
+    // Get resource of BAR or expansion ROM with a given index.
+    // Returns EMPTY resource if there is no such one.
+    const PciDevBarResource &GetBarRes(const uint32_t idx) const noexcept;
+
+    // Get v2p mapping descriptors of the BAR.
+    // NOTE: must not be called until @v2p_state_ is READY
+    std::span<const vm::VmallocEntry> GetBarV2PInfo(const PciDevBarResource &bar_res) const noexcept
+    {
+        return std::span(v2p_map_info_).subspan(bar_res.v2p_first_, bar_res.v2p_cnt_);
+    }
+
+    // Approximate memory footprint of the device object, including heap allocations
+    size_t MemUsage() const noexcept;
+
+    // Get index table entry for a capability, nullptr if the ID is out of the table
+    const uint16_t *GetCapIdxPos(const CapType cap_type, const uint16_t cap_id) const
+    {
+        EnsureCapsDecoded();
+
+        if (cap_type == CapType::compat)
+            return cap_id < compat_cap_id_cnt ? &compat_cap_idx_[cap_id] : nullptr;
+        else
+            return cap_id < ext_cap_id_cnt ? &ext_cap_idx_[cap_id] : nullptr;
+    }
+    V2PInfoState GetV2PInfoState() const noexcept
+    {
+        return v2p_state_.load(std::memory_order_acquire);
+    }
     virtual void ParseIDs(PciIdParser &parser);
 
     // Common registers for both Type 0 / Type 1 devices
@@ -184,6 +461,8 @@ struct PciDevBase
 
 struct PciType0Dev : public PciDevBase
 {
+    static constexpr pci_dev_type type_tag_ = pci_dev_type::TYPE0;
+
     using PciDevBase::PciDevBase;
 
     uint32_t get_bar0() const noexcept;
@@ -205,6 +484,8 @@ struct PciType0Dev : public PciDevBase
 
 struct PciType1Dev : public PciDevBase
 {
+    static constexpr pci_dev_type type_tag_ = pci_dev_type::TYPE1;
+
     using PciDevBase::PciDevBase;
 
     uint32_t get_bar0() const noexcept;
@@ -230,4 +511,16 @@ struct PciType1Dev : public PciDevBase
     void print_data() const noexcept;
 };
 
+// Downcast device object based on its type tag, nullptr is returned on type mismatch,
+// i.e. dev_cast<const PciType1Dev>(dev)
+template <typename T, typename B>
+    requires std::is_base_of_v<PciDevBase, std::remove_const_t<T>> &&
+             std::is_same_v<std::remove_const_t<B>, PciDevBase>
+constexpr T *dev_cast(B *dev) noexcept
+{
+    if (dev == nullptr || dev->type_ != std::remove_const_t<T>::type_tag_)
+        return nullptr;
+    return static_cast<T *>(dev);
+}
+
 } // namespace pci
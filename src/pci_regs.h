@@ -1677,6 +1677,40 @@ struct ARICap
 } __attribute__((packed));
 static_assert(sizeof(ARICap) == 0x8);
 
+struct RegSRIOVControl
+{
+    uint16_t vf_ena               : 1;
+    uint16_t vf_migration_ena     : 1;
+    uint16_t vf_migration_int_ena : 1;
+    uint16_t vf_mse               : 1;
+    uint16_t ari_cap_hier         : 1;
+    uint16_t vf_10bit_tag_req_ena : 1;
+    uint16_t rsvd0                : 10;
+} __attribute__((packed));
+static_assert(sizeof(RegSRIOVControl) == 2);
+
+struct SRIOVCap
+{
+    ExtCapHdr       hdr;                    // 0x0
+    uint32_t        sriov_cap;              // 0x4
+    RegSRIOVControl sriov_ctl;              // 0x8
+    uint16_t        sriov_status;           // 0xa
+    uint16_t        initial_vfs;            // 0xc
+    uint16_t        total_vfs;              // 0xe
+    uint16_t        num_vfs;                // 0x10
+    uint8_t         func_dep_link;          // 0x12
+    uint8_t         rsvd0;                  // 0x13
+    uint16_t        first_vf_off;           // 0x14
+    uint16_t        vf_stride;              // 0x16
+    uint16_t        rsvd1;                  // 0x18
+    uint16_t        vf_dev_id;              // 0x1a
+    uint32_t        supp_page_sizes;        // 0x1c
+    uint32_t        sys_page_size;          // 0x20
+    uint32_t        vf_bar[6];              // 0x24
+    uint32_t        vf_migration_state_off; // 0x3c
+} __attribute__((packed));
+static_assert(sizeof(SRIOVCap) == 0x40);
+
 struct RegPASIDCapability
 {
     uint16_t rsvd0                : 1;
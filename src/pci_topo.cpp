@@ -4,113 +4,528 @@
 #include "pci_dev.h"
 #include "pci_topo.h"
 #include "pci_regs.h"
+#include "config.h"
 #include "log.h"
 #include "util.h"
 
+#include <algorithm>
+#include <bit>
+#include <exception>
 #include <format>
+#include <thread>
 
 extern Logger logger;
+extern cfg::PCIexCfg pciex_cfg;
 
 namespace pci {
 
-void PCITopologyCtx::Populate(Provider &provider)
+// Create device out of @dev_desc and decode it.
+// Might be called concurrently from populate workers.
+PciDevBase *PCITopologyCtx::AddDevice(DeviceDesc &dev_desc, const bool parse_v2p)
 {
-    try {
-        auto devices = provider.GetPCIDevDescriptors();
-        if (devices.empty())
-            throw std::runtime_error("Failed to parse device descriptors");
+    const auto h_type = reinterpret_cast<uint8_t *>
+                 (dev_desc.cfg_space_.get() + e_to_type(Type0Cfg::header_type));
+    const auto dev_type = *h_type & 0x1 ? pci_dev_type::TYPE1 : pci_dev_type::TYPE0;
+    auto pci_dev = dev_arena_.Create(dev_desc.dbdf_,
+                                     cfg_space_type{dev_desc.cfg_space_len_},
+                                     dev_type,
+                                     std::move(dev_desc.cfg_space_));
+    // capabilities are decoded lazily, on the first access
+    pci_dev->DumpResources(dev_desc.resources_);
+    pci_dev->ParseBars(dev_desc.resources_);
+    // v2p mappings are resolved later in the background
+    if (parse_v2p)
+        pci_dev->v2p_state_ = V2PInfoState::PENDING;
 
+    if (iparser_.IsThreadSafe()) {
+        pci_dev->ParseIDs(iparser_);
+    } else {
+        std::lock_guard lock(iparser_mtx_);
+        pci_dev->ParseIDs(iparser_);
+    }
+
+    auto drv_name = dev_desc.driver_name_;
+    logger.log(Verbosity::INFO, "{} driver: {}", pci_dev->DevIdStr(),
+                drv_name.empty() ? "<none>" : drv_name);
+    return pci_dev;
+}
 
-        for (auto &dev_desc : devices) {
-            const auto h_type = reinterpret_cast<uint8_t *>
-                         (dev_desc.cfg_space_.get() + e_to_type(Type0Cfg::header_type));
-            const auto dev_type = *h_type & 0x1 ? pci_dev_type::TYPE1 : pci_dev_type::TYPE0;
-            auto pci_dev = dev_creator_.Create(dev_desc.dbdf_,
-                                               cfg_space_type{dev_desc.cfg_space_len_},
-                                               dev_type,
-                                               dev_desc.arg_,
-                                               std::move(dev_desc.cfg_space_));
-            pci_dev->ParseCapabilities();
-            pci_dev->DumpCapabilities();
-            pci_dev->AssignResources(dev_desc.resources_);
-            pci_dev->DumpResources();
-            pci_dev->ParseBars();
-            if (provider.ShouldParseV2PBarMappingInfo())
-                pci_dev->ParseBarsV2PMappings();
-            pci_dev->ParseIDs(iparser_);
-            auto drv_name = dev_desc.driver_name_;
-            logger.log(Verbosity::INFO, "{} driver: {}", pci_dev->dev_id_str_,
-                        drv_name.empty() ? "<none>" : drv_name);
-            devs_.push_back(std::move(pci_dev));
+// Device descriptors are decoded by @workers_cnt workers while the provider
+// is still producing them. Devices end up in @devs_ in arbitrary order.
+void PCITopologyCtx::PopulatePipelined(Provider &provider, const uint32_t workers_cnt,
+                                       const PopulateProgressCb &on_progress)
+{
+    const auto parse_v2p = provider.ShouldParseV2PBarMappingInfo();
+    BoundedQueue<DeviceDesc> queue(workers_cnt * populate_queue_depth_per_worker);
+
+    // decoded devices are handed over to the calling thread in batches
+    std::mutex                      decoded_mtx;
+    std::vector<PciDevBase *>       decoded;
+    std::vector<std::exception_ptr> worker_errs(workers_cnt);
+    std::vector<std::thread>        workers;
+
+    for (uint32_t i = 0; i < workers_cnt; i++) {
+        workers.emplace_back([&, i] {
+            try {
+                while (auto dev_desc = queue.Pop()) {
+                    auto dev = AddDevice(*dev_desc, parse_v2p);
+                    std::lock_guard lock(decoded_mtx);
+                    decoded.push_back(dev);
+                }
+            } catch (...) {
+                worker_errs[i] = std::current_exception();
+                // stop the producer
+                queue.Close();
+            }
+        });
+    }
+
+    // move the devices decoded so far to @devs_ and report them
+    auto collect_decoded = [&] {
+        const auto reported = devs_.size();
+        {
+            std::lock_guard lock(decoded_mtx);
+            devs_.insert(devs_.end(), decoded.begin(), decoded.end());
+            decoded.clear();
         }
+        if (on_progress && devs_.size() != reported)
+            on_progress(std::span(devs_).subspan(reported));
+    };
 
-        std::ranges::sort(devs_, [](const auto &a, const auto &b) {
-            uint64_t d_bdf_a = a->func_ | (a->dev_ << 8) | (a->bus_ << 16) | (a->dom_ << 24);
-            uint64_t d_bdf_b = b->func_ | (b->dev_ << 8) | (b->bus_ << 16) | (b->dom_ << 24);
-            return d_bdf_a < d_bdf_b;
+    std::exception_ptr producer_err;
+    size_t             produced = 0;
+    try {
+        provider.ForEachPCIDevDescriptor([&](DeviceDesc &&dev_desc) {
+            if (!queue.Push(std::move(dev_desc)))
+                throw std::runtime_error("Device descriptors decoding has been aborted");
+            if (++produced % populate_progress_step == 0)
+                collect_decoded();
         });
+    } catch (...) {
+        producer_err = std::current_exception();
+    }
+
+    queue.Close();
+    for (auto &worker : workers)
+        worker.join();
+
+    // report the root cause first
+    for (auto &err : worker_errs)
+        if (err)
+            std::rethrow_exception(err);
+    if (producer_err)
+        std::rethrow_exception(producer_err);
+
+    collect_decoded();
+}
+
+void PCITopologyCtx::Populate(Provider &provider, const PopulateProgressCb &on_progress)
+{
+    try {
+        const auto workers_cnt = pciex_cfg.common.populate_workers;
+        if (workers_cnt == 0) {
+            // descriptors are consumed as soon as they are produced, so
+            // only one of them is alive at a time
+            const auto parse_v2p = provider.ShouldParseV2PBarMappingInfo();
+            size_t reported = 0;
+            auto report_decoded = [&] {
+                if (on_progress && devs_.size() != reported)
+                    on_progress(std::span(devs_).subspan(reported));
+                reported = devs_.size();
+            };
+
+            provider.ForEachPCIDevDescriptor([&](DeviceDesc &&dev_desc) {
+                devs_.push_back(AddDevice(dev_desc, parse_v2p));
+                if (devs_.size() - reported == populate_progress_step)
+                    report_decoded();
+            });
+            report_decoded();
+        } else {
+            logger.log(Verbosity::INFO, "Populating topology using {} workers", workers_cnt);
+            PopulatePipelined(provider, workers_cnt, on_progress);
+        }
+
+        if (devs_.empty())
+            throw std::runtime_error("Failed to parse device descriptors");
+
+        // Sort once, regardless of the order devices have been decoded in.
+        // It is skipped entirely if the provider yields ordered output.
+        auto dbdf_key = [](const PciDevBase *dev) { return dev->dev_id_; };
+        if (!std::ranges::is_sorted(devs_, {}, dbdf_key))
+            RadixSort(devs_, dbdf_key);
+
+        for (uint32_t i = 0; i < devs_.size(); i++)
+            devs_[i]->topo_idx_ = i;
 
         auto bus_descs = provider.GetBusDescriptors();
         if (bus_descs.empty())
                 throw std::runtime_error("Failed to parse bus descriptors");
 
-        for (auto &bus : bus_descs) {
-            PCIBus pci_bus(std::get<0>(bus), std::get<1>(bus), std::get<2>(bus));
-            std::ranges::copy_if(devs_, std::back_inserter(pci_bus.devs_), [&](const auto &dev) {
-                    return dev->bus_ == std::get<1>(bus);
-            });
-            auto res = buses_.insert(std::make_pair(std::get<1>(bus), std::move(pci_bus)));
-            if (!res.second)
-                throw std::runtime_error(std::format("Failed to initialize bus {:02x}",
-                                         std::get<1>(bus)));
+        buses_.reserve(bus_descs.size());
+        for (auto &bus : bus_descs)
+            buses_.emplace_back(std::get<0>(bus), std::get<1>(bus), std::get<2>(bus));
+
+        std::ranges::sort(buses_, {}, [](const auto &bus) { return bus.Key(); });
+        auto dup = std::ranges::adjacent_find(buses_, {}, [](const auto &bus) { return bus.Key(); });
+        if (dup != buses_.end())
+            throw std::runtime_error(std::format("Failed to initialize bus {:04x}:{:02x}",
+                                     dup->dom_, dup->bus_nr_));
+
+        // Both devices and buses are sorted by (domain, bus),
+        // so devices are distributed over the buses in a single pass
+        size_t unassigned = 0;
+        auto bus_it = buses_.begin();
+        for (auto dev : devs_) {
+            auto dev_bus_key = PCIBus::Key(dev->dom_, dev->bus_);
+            while (bus_it != buses_.end() && bus_it->Key() < dev_bus_key)
+                bus_it++;
+
+            if (bus_it != buses_.end() && bus_it->Key() == dev_bus_key)
+                bus_it->devs_.push_back(dev);
+            else
+                unassigned++;
         }
+
+        if (unassigned != 0)
+            logger.log(Verbosity::WARN, "{} devices don't belong to any known bus", unassigned);
+
+        BuildTree();
+        ResolveVirtFns();
+
+        DumpMemUsage();
     } catch (std::exception &ex) {
         logger.log(Verbosity::FATAL, "Failed to populate the topology: {}", ex.what());
         throw;
     }
 }
 
+void PCITopologyCtx::ResolveV2PMappingsAsync(std::shared_future<void> vm_info_parsed,
+                                             std::function<void()> on_complete)
+{
+    v2p_resolve_ = std::async(std::launch::async, [this, vm_info_parsed,
+                                                   on_complete = std::move(on_complete)] {
+        try {
+            vm_info_parsed.get();
+        } catch (std::exception &ex) {
+            // devices would be marked as resolved without any v2p info
+            logger.log(Verbosity::ERR, "Failed to parse vmalloc info: {}", ex.what());
+        }
+
+        size_t resolved = 0;
+        for (auto &dev : devs_) {
+            if (dev->GetV2PInfoState() == V2PInfoState::PENDING) {
+                dev->ParseBarsV2PMappings();
+                resolved++;
+            }
+        }
+
+        logger.log(Verbosity::INFO, "Resolved BARs v2p mappings for {} devices", resolved);
+
+        if (on_complete)
+            on_complete();
+    });
+}
+
+void PCITopologyCtx::WaitV2PMappings()
+{
+    if (v2p_resolve_.valid())
+        v2p_resolve_.wait();
+}
+
 // Get topology intermidiate state using @capture_provider
 // and store it using @store_provider
 void PCITopologyCtx::Capture(Provider &capture_provider,
                              Provider &store_provider)
 {
     try {
-        auto devices = capture_provider.GetPCIDevDescriptors();
-        auto bus_descs = capture_provider.GetBusDescriptors();
-
-        store_provider.SaveState(devices, bus_descs);
+        // stream device descriptors straight into the storage,
+        // buses metadata is written last anyway
+        store_provider.BeginSaveState();
+        capture_provider.ForEachPCIDevDescriptor([&](DeviceDesc &&dev_desc) {
+            store_provider.SaveDevice(dev_desc);
+        });
+        store_provider.EndSaveState(capture_provider.GetBusDescriptors());
     } catch (std::exception &ex) {
         logger.log(Verbosity::FATAL, "Failed to capture topology state: {}", ex.what());
         throw;
     }
 }
 
+void PCITopoTree::Build(const std::vector<uint32_t> &parents)
+{
+    const auto nodes_cnt = static_cast<uint32_t>(parents.size());
+    parent_ = parents;
+
+    // Break possible cycles (e.g. bogus secondary bus numbers) by turning
+    // the first node found on a cycle into a root
+    enum : uint8_t { NEW, IN_PATH, DONE };
+    std::vector<uint8_t> state(nodes_cnt, NEW);
+    std::vector<uint32_t> path;
+    for (uint32_t i = 0; i < nodes_cnt; i++) {
+        auto node = i;
+        while (node != topo_no_node && state[node] == NEW) {
+            state[node] = IN_PATH;
+            path.push_back(node);
+            node = parent_[node];
+        }
+
+        if (node != topo_no_node && state[node] == IN_PATH) {
+            logger.log(Verbosity::WARN, "Devices tree has a cycle at node {}", node);
+            parent_[node] = topo_no_node;
+        }
+
+        for (auto n : path)
+            state[n] = DONE;
+        path.clear();
+    }
+
+    // Children lists preserve devices order
+    first_child_.assign(nodes_cnt, topo_no_node);
+    next_sibling_.assign(nodes_cnt, topo_no_node);
+    for (auto i = nodes_cnt; i-- > 0;) {
+        if (parent_[i] == topo_no_node)
+            continue;
+        next_sibling_[i] = first_child_[parent_[i]];
+        first_child_[parent_[i]] = i;
+    }
+
+    // Iterative DFS over the forest computing Euler tour intervals
+    depth_.assign(nodes_cnt, 0);
+    root_.assign(nodes_cnt, topo_no_node);
+    tin_.assign(nodes_cnt, 0);
+    tout_.assign(nodes_cnt, 0);
+    order_.clear();
+    order_.reserve(nodes_cnt);
+
+    // @stack holds the path from the root, @next_child holds the next child
+    // to be visited for each node on the path
+    uint16_t max_depth = 0;
+    std::vector<uint32_t> stack, next_child;
+    for (uint32_t r = 0; r < nodes_cnt; r++) {
+        if (parent_[r] != topo_no_node)
+            continue;
+
+        root_[r] = r;
+        tin_[r] = order_.size();
+        order_.push_back(r);
+        stack.push_back(r);
+        next_child.push_back(first_child_[r]);
+
+        while (!stack.empty()) {
+            auto child = next_child.back();
+            if (child == topo_no_node) {
+                tout_[stack.back()] = order_.size();
+                stack.pop_back();
+                next_child.pop_back();
+                continue;
+            }
+
+            next_child.back() = next_sibling_[child];
+            depth_[child] = depth_[stack.back()] + 1;
+            max_depth = std::max(max_depth, depth_[child]);
+            root_[child] = r;
+            tin_[child] = order_.size();
+            order_.push_back(child);
+            stack.push_back(child);
+            next_child.push_back(first_child_[child]);
+        }
+    }
+
+    // Binary lifting table
+    auto levels = std::max<size_t>(1, std::bit_width(max_depth));
+    up_.assign(levels, std::vector<uint32_t>(nodes_cnt, topo_no_node));
+    up_[0] = parent_;
+    for (size_t k = 1; k < levels; k++) {
+        for (uint32_t i = 0; i < nodes_cnt; i++) {
+            auto mid = up_[k - 1][i];
+            up_[k][i] = mid == topo_no_node ? topo_no_node : up_[k - 1][mid];
+        }
+    }
+}
+
+uint32_t PCITopoTree::LCA(uint32_t a, uint32_t b) const noexcept
+{
+    if (root_[a] != root_[b])
+        return topo_no_node;
+
+    if (IsAncestor(a, b))
+        return a;
+    if (IsAncestor(b, a))
+        return b;
+
+    // climb up from @a while staying below the LCA
+    for (auto k = up_.size(); k-- > 0;) {
+        auto anc = up_[k][a];
+        if (anc != topo_no_node && !IsAncestor(anc, b))
+            a = anc;
+    }
+
+    return parent_[a];
+}
+
+void PCITopologyCtx::BuildTree()
+{
+    std::vector<uint32_t> parents(devs_.size(), topo_no_node);
+
+    // bridge, which secondary bus is the bus at the same position in @buses_
+    std::vector<uint32_t> bus_upstream(buses_.size(), topo_no_node);
+    for (const auto dev : devs_) {
+        auto type1_dev = dev_cast<PciType1Dev>(dev);
+        if (type1_dev == nullptr)
+            continue;
+
+        auto sec_bus = FindBus(dev->dom_, type1_dev->get_sec_bus_num());
+        if (sec_bus == nullptr)
+            continue;
+
+        auto &upstream = bus_upstream[sec_bus - buses_.data()];
+        if (upstream == topo_no_node)
+            upstream = dev->topo_idx_;
+        else
+            logger.log(Verbosity::WARN, "Bus {:04x}:{:02x} has multiple upstream bridges",
+                       sec_bus->dom_, sec_bus->bus_nr_);
+    }
+
+    for (size_t i = 0; i < buses_.size(); i++)
+        for (const auto dev : buses_[i].devs_)
+            parents[dev->topo_idx_] = bus_upstream[i];
+
+    tree_.Build(parents);
+}
+
+PciDevBase *PCITopologyCtx::GetPhysFn(const PciDevBase *dev) const noexcept
+{
+    auto pf = phys_fn_[dev->topo_idx_];
+    return pf == topo_no_node ? nullptr : devs_[pf];
+}
+
+std::span<PciDevBase * const> PCITopologyCtx::GetVirtFns(const PciDevBase *pf) const noexcept
+{
+    auto it = virt_fns_.find(pf->topo_idx_);
+    if (it == virt_fns_.end())
+        return {};
+    return it->second;
+}
+
+const PCIBus *PCITopologyCtx::FindBus(const uint16_t dom, const uint16_t bus_nr) const noexcept
+{
+    auto key = PCIBus::Key(dom, bus_nr);
+    auto it = std::ranges::lower_bound(buses_, key, {}, [](const auto &bus) { return bus.Key(); });
+    if (it == buses_.end() || it->Key() != key)
+        return nullptr;
+
+    return &*it;
+}
+
 void PCITopologyCtx::DumpData() const noexcept
 {
     for (const auto &el : devs_)
         el->print_data();
 }
 
-void PCITopologyCtx::PrintBus(const PCIBus &bus, int off)
+// Look for SR-IOV capability walking the extended capabilities list directly,
+// so that capabilities of every device don't have to be decoded just for that.
+// Returns zero if there is no such capability.
+static uint16_t FindSRIOVCapOff(const PciDevBase *dev) noexcept
 {
-    for (const auto &dev : bus.devs_) {
-        if (dev->type_ == pci::pci_dev_type::TYPE1) {
-            auto fmt_str = std::format("{:\t>{}} \\--> {}", "", off, dev->dev_id_str_);
-            logger.log(Verbosity::RAW, "{}", fmt_str);
+    if (dev->type_ != pci_dev_type::TYPE0 || dev->cfg_type_ != cfg_space_type::ECS)
+        return 0;
 
-            auto type1_dev = dynamic_cast<PciType1Dev *>(dev.get());
-            auto sec_bus = buses_.find(type1_dev->get_sec_bus_num());
-            if (sec_bus != buses_.end()) {
-                PrintBus(sec_bus->second, off + 1);
-            }
+    constexpr uint32_t cfg_len = e_to_type(cfg_space_type::ECS);
+    uint32_t off = ext_cap_cfg_off;
+    // every capability takes at least a dword, so it bounds looped lists
+    for (uint32_t i = 0; i < (cfg_len - ext_cap_cfg_off) / 4; i++) {
+        if (off < ext_cap_cfg_off || off + sizeof(ExtCapHdr) > cfg_len)
+            return 0;
 
-        } else {
-            auto fmt_str = std::format("{:\t>{}} \\--> {}", "", off, dev->dev_id_str_);
-            logger.log(Verbosity::RAW, "{}", fmt_str);
+        auto hdr = dev->load_cfg<ExtCapHdr>(off);
+        if (hdr.cap_id == e_to_type(ExtCapID::sriov))
+            return off + sizeof(SRIOVCap) <= cfg_len ? off : 0;
+        if (hdr.next_cap == 0)
+            return 0;
+        off = hdr.next_cap;
+    }
+
+    return 0;
+}
+
+// Match enabled VFs of every SR-IOV PF by their routing IDs.
+// VFs being offline (e.g. not captured into the snapshot) are skipped.
+void PCITopologyCtx::ResolveVirtFns()
+{
+    phys_fn_.assign(devs_.size(), topo_no_node);
+    virt_fns_.clear();
+
+    size_t vfs_cnt = 0;
+    for (const auto pf : devs_) {
+        auto off = FindSRIOVCapOff(pf);
+        if (off == 0)
+            continue;
+
+        auto sriov = pf->load_cfg<SRIOVCap>(off);
+        if (!sriov.sriov_ctl.vf_ena || sriov.num_vfs == 0)
+            continue;
+
+        const uint32_t pf_rid = pf->bus_ << 8 | pf->dev_ << 3 | pf->func_;
+        std::vector<PciDevBase *> vfs;
+        for (uint32_t i = 0; i < sriov.num_vfs; i++) {
+            const uint32_t rid = pf_rid + sriov.first_vf_off + i * sriov.vf_stride;
+            if (rid > UINT16_MAX)
+                break;
+
+            const uint64_t vf_id = static_cast<uint64_t>(pf->dom_) << 24 | (rid >> 8) << 16 |
+                                   (rid >> 3 & 0x1f) << 8 | (rid & 0x7);
+            auto it = std::ranges::lower_bound(devs_, vf_id, {},
+                                               [](const auto dev) { return dev->dev_id_; });
+            if (it == devs_.end() || (*it)->dev_id_ != vf_id || *it == pf ||
+                phys_fn_[(*it)->topo_idx_] != topo_no_node)
+                continue;
+
+            phys_fn_[(*it)->topo_idx_] = pf->topo_idx_;
+            vfs.push_back(*it);
+        }
+
+        if (!vfs.empty()) {
+            vfs_cnt += vfs.size();
+            virt_fns_.emplace(pf->topo_idx_, std::move(vfs));
         }
     }
 
+    if (vfs_cnt != 0)
+        logger.log(Verbosity::INFO, "SR-IOV: {} VFs of {} PFs", vfs_cnt, virt_fns_.size());
+}
+
+void PCITopologyCtx::DumpMemUsage() const noexcept
+{
+    if (devs_.empty())
+        return;
+
+    size_t total = 0;
+    for (const auto &dev : devs_)
+        total += dev->MemUsage();
+
+    // extrapolate to the max number of functions within a single PCI domain
+    constexpr size_t dom_max_funcs = 65536;
+    auto per_dev = total / devs_.size();
+    logger.log(Verbosity::INFO,
+               "Devices memory usage: {} devices -> {} bytes total, {} bytes per device "
+               "(object: Type0 {} / Type1 {}), ~{} KiB per {} devices",
+               devs_.size(), total, per_dev, sizeof(PciType0Dev), sizeof(PciType1Dev),
+               per_dev * dom_max_funcs / 1024, dom_max_funcs);
+}
+
+void PCITopologyCtx::PrintBus(const PCIBus &bus, int off)
+{
+    // subtree nodes come in DFS order, so relative depth gives the indentation
+    for (const auto &dev : bus.devs_) {
+        const auto base_depth = tree_.Depth(dev->topo_idx_);
+        for (auto node : tree_.Subtree(dev->topo_idx_)) {
+            auto fmt_str = std::format("{:\t>{}} \\--> {}", "",
+                                       off + tree_.Depth(node) - base_depth,
+                                       devs_[node]->DevIdStr());
+            logger.log(Verbosity::RAW, "{}", fmt_str);
+        }
+    }
 }
 
 } // namespace pci
@@ -3,7 +3,12 @@
 
 #pragma once
 
-#include <map>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <span>
+#include <unordered_map>
 
 #include "ids_parse.h"
 #include "provider_iface.h"
@@ -15,50 +20,152 @@ struct PCIBus
     uint16_t dom_;
     uint16_t bus_nr_;
     bool     is_root_ {false};
-    std::vector<std::shared_ptr<PciDevBase>> devs_;
+    std::vector<PciDevBase *> devs_;
 
     PCIBus(uint16_t dom, uint16_t nr, bool is_root)
         : dom_(dom), bus_nr_(nr), is_root_(is_root) {}
+
+    // (domain, bus) key, buses are ordered by it
+    static constexpr uint32_t Key(const uint16_t dom, const uint16_t nr) noexcept
+    {
+        return uint32_t{dom} << 8 | (nr & 0xff);
+    }
+    uint32_t Key() const noexcept { return Key(dom_, bus_nr_); }
 };
 
-class PciObjCreator
+// Owns device objects for the lifetime of the topology.
+// Devices are constructed in place and never move, so buses and UI
+// elements refer to them by plain pointers.
+class PciDevArena
 {
+    std::deque<PciType0Dev> type0_devs_;
+    std::deque<PciType1Dev> type1_devs_;
+    std::mutex              mtx_;
+
 public:
-    std::shared_ptr<PciDevBase>
+    // Thread-safe, devices might be created by multiple populate workers
+    PciDevBase *
     Create(uint64_t d_bdf, cfg_space_type cfg_len, pci_dev_type dev_type,
-           ProviderArg &p_arg, std::unique_ptr<uint8_t []> cfg_buf)
+           std::unique_ptr<uint8_t []> cfg_buf)
     {
+        std::lock_guard lock(mtx_);
         if (dev_type == pci_dev_type::TYPE0)
-            return std::make_shared<PciType0Dev>(d_bdf, cfg_len, dev_type, p_arg,
-                                                 std::move(cfg_buf));
+            return &type0_devs_.emplace_back(d_bdf, cfg_len, dev_type, std::move(cfg_buf));
         else
-            return std::make_shared<PciType1Dev>(d_bdf, cfg_len, dev_type, p_arg,
-                                                 std::move(cfg_buf));
+            return &type1_devs_.emplace_back(d_bdf, cfg_len, dev_type, std::move(cfg_buf));
+    }
+};
+
+constexpr uint32_t topo_no_node = UINT32_MAX;
+
+// Max number of device descriptors waiting to be decoded per populate worker
+constexpr uint32_t populate_queue_depth_per_worker = 16;
+
+// Populate progress is reported once per this number of devices
+constexpr uint32_t populate_progress_step = 64;
+
+// Called with the devices decoded since the previous call. Devices aren't
+// modified afterwards, except for their topology indices assigned at the end.
+using PopulateProgressCb = std::function<void(std::span<PciDevBase * const>)>;
+
+// Parent/child index of the devices tree, nodes are indices within topology
+// devices array. Parent of a device is the bridge, which secondary bus
+// the device resides on. Devices on root buses are the roots of the forest.
+struct PCITopoTree
+{
+    std::vector<uint32_t> parent_;
+    std::vector<uint32_t> first_child_;
+    std::vector<uint32_t> next_sibling_;
+    std::vector<uint16_t> depth_;
+    std::vector<uint32_t> root_;
+    // Euler tour: subtree of node @i occupies [tin_[i], tout_[i]) within @order_
+    std::vector<uint32_t> tin_;
+    std::vector<uint32_t> tout_;
+    std::vector<uint32_t> order_;
+    // binary lifting table for LCA queries: up_[k][i] is the 2^k-th ancestor of @i
+    std::vector<std::vector<uint32_t>> up_;
+
+    void Build(const std::vector<uint32_t> &parents);
+
+    size_t   Size() const noexcept { return parent_.size(); }
+    uint32_t Parent(const uint32_t node) const noexcept { return parent_[node]; }
+    uint32_t Root(const uint32_t node) const noexcept { return root_[node]; }
+    uint16_t Depth(const uint32_t node) const noexcept { return depth_[node]; }
+
+    // Check if @anc is an ancestor of @node, node is considered an ancestor of itself
+    bool IsAncestor(const uint32_t anc, const uint32_t node) const noexcept
+    {
+        return tin_[anc] <= tin_[node] && tout_[node] <= tout_[anc];
+    }
+
+    // Nodes of the subtree in DFS order, the first one is @node itself
+    std::span<const uint32_t> Subtree(const uint32_t node) const noexcept
+    {
+        return std::span(order_).subspan(tin_[node], tout_[node] - tin_[node]);
+    }
+
+    // Lowest common ancestor, topo_no_node if nodes are in different trees
+    uint32_t LCA(uint32_t a, uint32_t b) const noexcept;
+
+    // Call @func for each child of @node
+    template <typename F>
+    void ForEachChild(const uint32_t node, F &&func) const
+    {
+        for (auto child = first_child_[node]; child != topo_no_node; child = next_sibling_[child])
+            func(child);
     }
 };
 
 struct PCITopologyCtx
 {
     bool                                     live_mode_;
-    PciObjCreator                            dev_creator_;
+    PciDevArena                              dev_arena_;
     PciIdParser                              iparser_;
-    std::vector<std::shared_ptr<PciDevBase>> devs_;
-    std::map<uint16_t, PCIBus>               buses_;
+    // serializes ids lookups of populate workers, unless @iparser_ is thread-safe
+    std::mutex                               iparser_mtx_;
+    std::vector<PciDevBase *>                devs_;
+    // sorted by (domain, bus)
+    std::vector<PCIBus>                      buses_;
+    PCITopoTree                              tree_;
+    // SR-IOV: PF topology index of every VF, topo_no_node for other devices
+    std::vector<uint32_t>                    phys_fn_;
+    // VFs of the PFs with enabled VFs, keyed by PF topology index
+    std::unordered_map<uint32_t, std::vector<PciDevBase *>> virt_fns_;
+    std::future<void>                        v2p_resolve_;
 
     PCITopologyCtx(bool live_mode) :
         live_mode_(live_mode),
-        dev_creator_(),
+        dev_arena_(),
         iparser_(),
         devs_(),
         buses_()
     {}
 
-    void Populate(Provider &);
+    // @on_progress (if any) is called from the calling thread
+    void Populate(Provider &, const PopulateProgressCb &on_progress = {});
+    void PopulatePipelined(Provider &, const uint32_t workers_cnt,
+                           const PopulateProgressCb &on_progress);
+    PciDevBase *AddDevice(DeviceDesc &dev_desc, const bool parse_v2p);
+    // Wait for @vm_info_parsed and resolve BARs v2p mappings for all the devices
+    // in the background. @on_complete is called from the worker thread.
+    void ResolveV2PMappingsAsync(std::shared_future<void> vm_info_parsed,
+                                 std::function<void()> on_complete);
+    void WaitV2PMappings();
+    // Get bus by domain and bus number, nullptr if there is no such bus
+    const PCIBus *FindBus(const uint16_t dom, const uint16_t bus_nr) const noexcept;
+    // SR-IOV PF of @dev, nullptr if it's not a VF
+    PciDevBase *GetPhysFn(const PciDevBase *dev) const noexcept;
+    // SR-IOV VFs of @pf in routing ID order, empty if there are none
+    std::span<PciDevBase * const> GetVirtFns(const PciDevBase *pf) const noexcept;
     void DumpData() const noexcept;
+    void DumpMemUsage() const noexcept;
     void Capture(Provider &, Provider &);
 
     //XXX: DEBUG
     void PrintBus(const PCIBus &, int off);
+
+    void BuildTree();
+    void ResolveVirtFns();
 };
 
 } // namespace pci
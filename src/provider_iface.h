@@ -5,7 +5,9 @@
 
 #include <cstdint>
 #include <filesystem>
+#include <functional>
 #include <memory>
+#include <string>
 #include <variant>
 #include <vector>
 
@@ -41,11 +43,26 @@ struct Provider
     virtual
     std::vector<DeviceDesc> GetPCIDevDescriptors() = 0;
 
+    // Streaming variant of GetPCIDevDescriptors(): @visitor is called for every
+    // device descriptor as soon as it has been produced. Exceptions thrown by
+    // @visitor abort the iteration.
     virtual
-    bool ShouldParseV2PBarMappingInfo() = 0;
+    void ForEachPCIDevDescriptor(const std::function<void(DeviceDesc &&)> &visitor)
+    {
+        for (auto &dev_desc : GetPCIDevDescriptors())
+            visitor(std::move(dev_desc));
+    }
 
     virtual
-    void SaveState(const std::vector<DeviceDesc> &devs,
-                   const std::vector<BusDesc> &buses) = 0;
+    bool ShouldParseV2PBarMappingInfo() = 0;
 
+    // State saving is split into three steps, so devices could be streamed
+    // into the storage one by one without materialising the whole topology:
+    // BeginSaveState() -> SaveDevice() for every device -> EndSaveState()
+    virtual
+    void BeginSaveState() = 0;
+    virtual
+    void SaveDevice(const DeviceDesc &dev) = 0;
+    virtual
+    void EndSaveState(const std::vector<BusDesc> &buses) = 0;
 };
@@ -4,6 +4,7 @@
 #include "log.h"
 #include "snapshot.h"
 #include <chrono>
+#include <cstddef>
 #include <cstring>
 #include <numeric>
 
@@ -95,8 +96,8 @@ SnapshotProvider::WriteDeviceMetadata(const DeviceDesc &dev_desc)
     auto dev  = dev_desc.dbdf_ >> 8 & 0xff;
     auto func = dev_desc.dbdf_ & 0xff;
 
-    logger.log(Verbosity::INFO, "snapshot: saving metadata for [{:04x}|{:02x}:{:02x}.{:x}] device [{} / {}]",
-               dom, bus, dev, func, ++cur_dev_num_, total_dev_num_);
+    logger.log(Verbosity::INFO, "snapshot: saving metadata for [{:04x}|{:02x}:{:02x}.{:x}] device #{}",
+               dom, bus, dev, func, ++cur_dev_num_);
 
     meta::SDeviceMd static_dev_md;
     static_dev_md.d_bdf_ = dev_desc.dbdf_;
@@ -106,7 +107,9 @@ SnapshotProvider::WriteDeviceMetadata(const DeviceDesc &dev_desc)
     static_dev_md.iommu_group_ = dev_desc.iommu_group_;
     static_dev_md.driver_name_len_ = dev_desc.driver_name_.empty() ?
                                      0 : dev_desc.driver_name_.length() + 1;
-    static_dev_md.is_final_dev_entry_ = (cur_dev_num_ == total_dev_num_) ? 1 : 0;
+    // Total number of devices is not known while streaming, so the last
+    // entry is marked once all devices have been written
+    static_dev_md.is_final_dev_entry_ = 0;
 
     iovec_[0].iov_base = &static_dev_md;
     iovec_[0].iov_len = sizeof(static_dev_md);
@@ -162,6 +165,7 @@ SnapshotProvider::WriteDeviceMetadata(const DeviceDesc &dev_desc)
         return false;
     }
 
+    last_dev_md_off_ = off_;
     bytes_written_ += total_iovec_data_len;
     off_ += total_iovec_data_len;
 
@@ -172,6 +176,23 @@ SnapshotProvider::WriteDeviceMetadata(const DeviceDesc &dev_desc)
     return true;
 }
 
+bool
+SnapshotProvider::MarkFinalDeviceEntry()
+{
+    const uint8_t is_final = 1;
+    auto flag_off = last_dev_md_off_ + offsetof(meta::SDeviceMd, is_final_dev_entry_);
+
+    auto res = pwrite(fd_, &is_final, sizeof(is_final), flag_off);
+    if (res != sizeof(is_final)) {
+        logger.log(Verbosity::FATAL,
+                   "snapshot: Failed to mark device #{} as the last one, off {} err {}",
+                   cur_dev_num_, flag_off, errno);
+        return false;
+    }
+
+    return true;
+}
+
 bool
 SnapshotProvider::WriteBusesMetadata(const std::vector<BusDesc> &buses)
 {
@@ -221,23 +242,36 @@ SnapshotProvider::WriteBusesMetadata(const std::vector<BusDesc> &buses)
 }
 
 void
-SnapshotProvider::SaveState(const std::vector<DeviceDesc> &devs,
-                            const std::vector<BusDesc> &buses)
+SnapshotProvider::BeginSaveState()
+{
+    if (!SnapshotCapturePrepare())
+        throw std::runtime_error("Failed to create snapshot");
+}
+
+void
+SnapshotProvider::SaveDevice(const DeviceDesc &dev)
+{
+    if (!WriteDeviceMetadata(dev))
+        throw std::runtime_error("Failed to create snapshot");
+}
+
+void
+SnapshotProvider::EndSaveState(const std::vector<BusDesc> &buses)
 {
     auto save_error = []{ throw std::runtime_error("Failed to create snapshot"); };
 
-    if (!SnapshotCapturePrepare())
+    if (cur_dev_num_ == 0) {
+        logger.log(Verbosity::FATAL, "snapshot: No devices have been saved");
         return save_error();
+    }
 
-    total_dev_num_ = devs.size();
-    for (const auto &dev_desc : devs)
-        if (!WriteDeviceMetadata(dev_desc))
-            return save_error();
+    if (!MarkFinalDeviceEntry())
+        return save_error();
 
     if (!WriteBusesMetadata(buses))
         return save_error();
 
-    if (!StoreMainHeader(bytes_written_, devs.size(), buses.size()))
+    if (!StoreMainHeader(bytes_written_, cur_dev_num_, buses.size()))
         return save_error();
 
     if (!SnapshotFinalize())
@@ -376,12 +410,21 @@ SnapshotProvider::GetBusDescriptors()
 
 std::vector<DeviceDesc>
 SnapshotProvider::GetPCIDevDescriptors()
+{
+    std::vector<DeviceDesc> devices;
+    ForEachPCIDevDescriptor([&](DeviceDesc &&dev_desc) {
+        devices.push_back(std::move(dev_desc));
+    });
+    return devices;
+}
+
+void
+SnapshotProvider::ForEachPCIDevDescriptor(const std::function<void(DeviceDesc &&)> &visitor)
 {
     if (!SnapshotParsePrepare())
         throw std::runtime_error("Invalid snapshot metadata");
 
     auto parse_error = []() { throw std::runtime_error("Failed to parse snapshot"); };
-    std::vector<DeviceDesc> devices;
 
     do {
         // read device static metadata
@@ -430,15 +473,17 @@ SnapshotProvider::GetPCIDevDescriptors()
             parse_error();
         }
 
-        // prepare dynamic md buffer
-        auto dyn_md_size = res_desc_cnt * dev_res_desc_size +
-                           dev_static_meta->driver_name_len_;
-        dyn_md_buf_.reset(new (std::nothrow) uint8_t[dyn_md_size]);
-        if (dyn_md_buf_ == nullptr) {
-            logger.log(Verbosity::FATAL, "snapshot: Failed to allocate dyn md buffer");
-            parse_error();
+        // prepare dynamic md buffer, it's reused across the devices
+        size_t dyn_md_size = res_desc_cnt * dev_res_desc_size +
+                             dev_static_meta->driver_name_len_;
+        if (cur_dyn_md_buf_len_ < dyn_md_size || dyn_md_buf_ == nullptr) {
+            dyn_md_buf_.reset(new (std::nothrow) uint8_t[dyn_md_size]);
+            if (dyn_md_buf_ == nullptr) {
+                logger.log(Verbosity::FATAL, "snapshot: Failed to allocate dyn md buffer");
+                parse_error();
+            }
+            cur_dyn_md_buf_len_ = dyn_md_size;
         }
-        cur_dyn_md_buf_len_ = dyn_md_size;
 
         // prepare cfg space buffer
         OpaqueBuf dev_cfg_space_buf(new (std::nothrow) uint8_t[cfg_len]);
@@ -494,21 +539,19 @@ SnapshotProvider::GetPCIDevDescriptors()
         }
 
         // construct @DeviceDesc
-        devices.emplace_back(dev_static_meta->d_bdf_,
-                             cfg_len,
-                             std::move(dev_cfg_space_buf),
-                             std::move(dev_resources),
-                             std::move(drv_name),
-                             dev_static_meta->numa_node_,
-                             dev_static_meta->iommu_group_,
-                             // FIXME: it's not clear what's the point of passing
-                             // dyn md buffer to @PciDevBase
-                             nullptr);
+        visitor(DeviceDesc(dev_static_meta->d_bdf_,
+                           cfg_len,
+                           std::move(dev_cfg_space_buf),
+                           std::move(dev_resources),
+                           std::move(drv_name),
+                           dev_static_meta->numa_node_,
+                           dev_static_meta->iommu_group_,
+                           // FIXME: it's not clear what's the point of passing
+                           // dyn md buffer to @PciDevBase
+                           nullptr));
 
         cur_dev_num_ += 1;
     } while (cur_dev_num_ <= total_dev_num_);
-
-    return devices;
 }
 
 } // namespace snapshot
@@ -90,6 +90,7 @@ public:
         total_dev_num_(0),
         total_bus_num_(0),
         off_(0),
+        last_dev_md_off_(0),
         fd_(-1),
         dyn_md_buf_(nullptr),
         cur_dyn_md_buf_len_(0),
@@ -104,11 +105,14 @@ public:
 
     std::vector<BusDesc>         GetBusDescriptors() override;
     std::vector<DeviceDesc>      GetPCIDevDescriptors() override;
+    void                         ForEachPCIDevDescriptor(
+                                     const std::function<void(DeviceDesc &&)> &visitor) override;
     std::string                  GetProviderName() const override { return "Snapshot"; }
     bool                         ShouldParseV2PBarMappingInfo() override { return false; }
 
-    void SaveState(const std::vector<DeviceDesc> &devs,
-                   const std::vector<BusDesc> &buses) override;
+    void BeginSaveState() override;
+    void SaveDevice(const DeviceDesc &dev) override;
+    void EndSaveState(const std::vector<BusDesc> &buses) override;
 
 private:
     uint64_t                          bytes_written_;
@@ -117,6 +121,7 @@ private:
     uint32_t                          total_dev_num_;
     uint32_t                          total_bus_num_;
     size_t                            off_;
+    size_t                            last_dev_md_off_;   // offset of the last written @SDeviceMd
     int                               fd_;
     OpaqueBuf                         dyn_md_buf_;
     size_t                            cur_dyn_md_buf_len_;
@@ -131,6 +136,7 @@ private:
     bool SnapshotParsePrepare();
     bool SnapshotFinalize();
     bool WriteDeviceMetadata(const DeviceDesc &dev_desc);
+    bool MarkFinalDeviceEntry();
     bool WriteBusesMetadata(const std::vector<BusDesc> &buses);
 };
 
@@ -30,8 +30,8 @@ Element PushPullButton::OnRender()
                       active ? ftxui::select :
                       ftxui::nothing;
 
-    if (ena_flag_ != nullptr)
-        is_pressed_ = (*ena_flag_ == 1);
+    if (ena_flag_.Valid())
+        is_pressed_ = ena_flag_.Get();
 
     const EntryState state = {
         *label,
@@ -148,18 +148,18 @@ static ButtonOption RegButtonDefaultOption() {
 }
 
 static Component
-PPButton(ConstStringRef label, uint8_t *on_click, ButtonOption option)
+PPButton(ConstStringRef label, RegVisHandle on_click, ButtonOption option)
 {
   option.label = label;
-  if (on_click == nullptr)
+  if (!on_click.Valid())
       option.on_click = [] {};
   else
-      option.on_click = [on_click] { *on_click = *on_click ? false : true; };
+      option.on_click = [on_click] { on_click.Toggle(); };
 
   return Make<PushPullButton>(std::move(option), on_click);
 }
 
-Component RegButtonComp(std::string label, uint8_t *on_click)
+Component RegButtonComp(std::string label, RegVisHandle on_click)
 {
     return PPButton(label, on_click, ui::RegButtonDefaultOption());
 }
@@ -253,11 +253,12 @@ static std::string RegTypeLabel(const compat_reg_type_t reg_type)
 }
 
 Component
-GetCompMaybe(Element elem, const uint8_t *on_click)
+GetCompMaybe(Element elem, RegVisHandle on_click)
 {
-    return Renderer([=] {
-                return vbox({std::move(elem), separatorEmpty()});
-           }) | Maybe([on_click] { return *on_click == 1; });
+    // the same element is returned on every render, so its measured size
+    // can be reused by the virtual list
+    auto item = vbox({std::move(elem), separatorEmpty()});
+    return Renderer([=] { return item; }) | Maybe([on_click] { return on_click.Get(); });
 }
 
 Element
@@ -312,18 +313,23 @@ GetHexDumpElem(std::string desc, const uint8_t *buf, const size_t len,
     return vbox(std::move(lines));
 }
 
-static Component
-CreateRegInfoCompat(const compat_reg_type_t reg_type, Element content,
-                    const uint8_t *on_click)
+static Element
+RegInfoCompatWindow(const compat_reg_type_t reg_type, Element content)
 {
     auto title = text(std::format("Compat Cfg Space Hdr -> {}", RegTypeLabel(reg_type))) |
                              inverted | align_right | bold;
-    auto info_window = window(std::move(title), std::move(content));
-    return GetCompMaybe(std::move(info_window), on_click);
+    return window(std::move(title), std::move(content));
+}
+
+static Component
+CreateRegInfoCompat(const compat_reg_type_t reg_type, Element content,
+                    RegVisHandle on_click)
+{
+    return GetCompMaybe(RegInfoCompatWindow(reg_type, std::move(content)), on_click);
 }
 
 static Component
-RegInfoVIDComp(const pci::PciDevBase *dev, const uint8_t *on_click)
+RegInfoVIDComp(const pci::PciDevBase *dev, RegVisHandle on_click)
 {
     auto content = text(std::format("[{:02x}] -> {}", dev->get_vendor_id(),
                                         dev->ids_names_[pci::VENDOR].empty() ?
@@ -332,7 +338,7 @@ RegInfoVIDComp(const pci::PciDevBase *dev, const uint8_t *on_click)
 }
 
 static Component
-RegInfoDevIDComp(const pci::PciDevBase *dev, const uint8_t *on_click)
+RegInfoDevIDComp(const pci::PciDevBase *dev, RegVisHandle on_click)
 {
     auto content = text(std::format("[{:02x}] -> {}", dev->get_device_id(),
                                         dev->ids_names_[pci::DEVICE].empty() ?
@@ -341,7 +347,7 @@ RegInfoDevIDComp(const pci::PciDevBase *dev, const uint8_t *on_click)
 }
 
 static Component
-RegInfoCommandComp(const pci::PciDevBase *dev, const uint8_t *on_click)
+RegInfoCommandComp(const pci::PciDevBase *dev, RegVisHandle on_click)
 {
     auto command = dev->get_command();
     auto reg = reinterpret_cast<const RegCommand *>(&command);
@@ -363,7 +369,7 @@ RegInfoCommandComp(const pci::PciDevBase *dev, const uint8_t *on_click)
 }
 
 static Component
-RegInfoStatusComp(const pci::PciDevBase *dev, const uint8_t *on_click)
+RegInfoStatusComp(const pci::PciDevBase *dev, RegVisHandle on_click)
 {
     auto status = dev->get_status();
     auto reg = reinterpret_cast<const RegStatus *>(&status);
@@ -387,14 +393,14 @@ RegInfoStatusComp(const pci::PciDevBase *dev, const uint8_t *on_click)
 }
 
 static Component
-RegInfoRevComp(const pci::PciDevBase *dev, const uint8_t *on_click)
+RegInfoRevComp(const pci::PciDevBase *dev, RegVisHandle on_click)
 {
     auto content = text(std::format("{:02x}", dev->get_rev_id()));
     return CreateRegInfoCompat(Type0Cfg::revision, std::move(content), on_click);
 }
 
 static Component
-RegInfoCCComp(const pci::PciDevBase *dev, const uint8_t *on_click)
+RegInfoCCComp(const pci::PciDevBase *dev, RegVisHandle on_click)
 {
     auto cc = dev->get_class_code();
 
@@ -427,7 +433,7 @@ RegInfoCCComp(const pci::PciDevBase *dev, const uint8_t *on_click)
 }
 
 static Component
-RegInfoClSizeComp(const pci::PciDevBase *dev, const uint8_t *on_click)
+RegInfoClSizeComp(const pci::PciDevBase *dev, RegVisHandle on_click)
 {
     auto content = text(std::format("Cache Line size: {} bytes",
                                dev->get_cache_line_size() * 4));
@@ -435,14 +441,14 @@ RegInfoClSizeComp(const pci::PciDevBase *dev, const uint8_t *on_click)
 }
 
 static Component
-RegInfoLatTmrComp(const pci::PciDevBase *dev, const uint8_t *on_click)
+RegInfoLatTmrComp(const pci::PciDevBase *dev, RegVisHandle on_click)
 {
     auto content = text(std::format("Latency Tmr: {:02x}", dev->get_lat_timer()));
     return CreateRegInfoCompat(Type0Cfg::latency_timer, std::move(content), on_click);
 }
 
 static Component
-RegInfoHdrTypeComp(const pci::PciDevBase *dev, const uint8_t *on_click)
+RegInfoHdrTypeComp(const pci::PciDevBase *dev, RegVisHandle on_click)
 {
     auto hdr_type = dev->get_header_type();
     auto reg = reinterpret_cast<const RegHdrType *>(&hdr_type);
@@ -457,7 +463,7 @@ RegInfoHdrTypeComp(const pci::PciDevBase *dev, const uint8_t *on_click)
 }
 
 static Component
-RegInfoBISTComp(const pci::PciDevBase *dev, const uint8_t *on_click)
+RegInfoBISTComp(const pci::PciDevBase *dev, RegVisHandle on_click)
 {
     auto bist = dev->get_bist();
     auto reg = reinterpret_cast<const RegBIST *>(&bist);
@@ -559,14 +565,37 @@ GetBarElem(UIBarElemType type, uint32_t bar)
     return reg_box;
 }
 
+// Append v2p mapping info of the BAR, if any.
+// Device v2p info state is expected to be either READY or NONE.
+static void
+AddBarV2PInfoElems(const pci::PciDevBase *dev, const uint32_t bar_idx, Elements &elems)
+{
+    const auto &bar_res = dev->GetBarRes(bar_idx);
+    if (bar_res.v2p_cnt_ == 0)
+        return;
+
+    auto pa_start = bar_res.phys_addr_;
+    auto pa_end = bar_res.phys_addr_ + bar_res.len_;
+
+    elems.push_back(separatorEmpty());
+    elems.push_back(text(std::format("v2p mappings for PA range [{:#x} - {:#x}]:",
+                                     pa_start, pa_end)));
+    for (const auto &vm_e : dev->GetBarV2PInfo(bar_res)) {
+        elems.push_back(
+            text(std::format("VA range [{:#x} - {:#x}] -> PA {:#x} len {:#x}",
+                             vm_e.start_, vm_e.end_, vm_e.pa_, vm_e.len_))
+        );
+    }
+}
+
 static Component
 RegInfoBARComp(const pci::PciDevBase *dev, const compat_reg_type_t reg_type,
-               const uint8_t *on_click)
+               RegVisHandle on_click)
 {
     uint32_t bar, bar_idx;
 
     if (dev->type_ == pci::pci_dev_type::TYPE0) {
-        auto type0_dev = dynamic_cast<const pci::PciType0Dev *>(dev);
+        auto type0_dev = pci::dev_cast<const pci::PciType0Dev>(dev);
 
         switch (std::get<Type0Cfg>(reg_type)) {
         case Type0Cfg::bar0:
@@ -597,7 +626,7 @@ RegInfoBARComp(const pci::PciDevBase *dev, const compat_reg_type_t reg_type,
             assert(false);
         }
     } else {
-        auto type1_dev = dynamic_cast<const pci::PciType1Dev *>(dev);
+        auto type1_dev = pci::dev_cast<const pci::PciType1Dev>(dev);
 
         switch (std::get<Type1Cfg>(reg_type)) {
         case Type1Cfg::bar0:
@@ -617,8 +646,8 @@ RegInfoBARComp(const pci::PciDevBase *dev, const compat_reg_type_t reg_type,
 
     uint32_t prev_bar_idx = (bar_idx > 0) ? (bar_idx - 1) : 0;
 
-    const auto &cur_bar_res = dev->bar_res_[bar_idx];
-    const auto &prev_bar_res = dev->bar_res_[prev_bar_idx];
+    const auto &cur_bar_res = dev->GetBarRes(bar_idx);
+    const auto &prev_bar_res = dev->GetBarRes(prev_bar_idx);
 
     if (cur_bar_res.type_ == pci::ResourceType::IO) {
         auto reg_box = GetBarElem(UIBarElemType::IoSpace, bar);
@@ -674,22 +703,34 @@ RegInfoBARComp(const pci::PciDevBase *dev, const compat_reg_type_t reg_type,
             desc
         };
 
-        if (cur_bar_res.has_v2p_info_) {
-            auto pa_start = cur_bar_res.phys_addr_;
-            auto pa_end = cur_bar_res.phys_addr_ + cur_bar_res.len_;
-
-            content_elems.push_back(separatorEmpty());
-            content_elems.push_back(
-                    text(std::format("v2p mappings for PA range [{:#x} - {:#x}]:",
-                                     pa_start, pa_end)));
-            for (const auto &vm_e : dev->v2p_bar_map_info_[bar_idx]) {
-                content_elems.push_back(
-                    text(std::format("VA range [{:#x} - {:#x}] -> PA {:#x} len {:#x}",
-                                     vm_e.start_, vm_e.end_, vm_e.pa_, vm_e.len_))
-                );
-            }
+        // v2p mappings are resolved in the background, so the content
+        // is rebuilt on each render until they are ready
+        if (dev->GetV2PInfoState() == pci::V2PInfoState::PENDING) {
+            return Renderer([=, ready_content = Element{}]() mutable {
+                if (ready_content == nullptr) {
+                    if (dev->GetV2PInfoState() != pci::V2PInfoState::READY) {
+                        auto pending_elems = content_elems;
+                        pending_elems.push_back(separatorEmpty());
+                        pending_elems.push_back(text("v2p mappings: resolving…") | dim);
+                        return vbox({
+                            RegInfoCompatWindow(reg_type, vbox(std::move(pending_elems))),
+                            separatorEmpty()
+                        });
+                    }
+
+                    auto elems = content_elems;
+                    AddBarV2PInfoElems(dev, bar_idx, elems);
+                    ready_content = vbox({
+                        RegInfoCompatWindow(reg_type, vbox(std::move(elems))),
+                        separatorEmpty()
+                    });
+                }
+
+                return ready_content;
+            }) | Maybe([on_click] { return on_click.Get(); });
         }
 
+        AddBarV2PInfoElems(dev, bar_idx, content_elems);
         content = vbox(content_elems);
     }
 
@@ -697,17 +738,17 @@ RegInfoBARComp(const pci::PciDevBase *dev, const compat_reg_type_t reg_type,
 }
 
 static Component
-RegInfoCardbusCISComp(const pci::PciDevBase *dev, const uint8_t *on_click)
+RegInfoCardbusCISComp(const pci::PciDevBase *dev, RegVisHandle on_click)
 {
-    auto type0_dev = dynamic_cast<const pci::PciType0Dev *>(dev);
+    auto type0_dev = pci::dev_cast<const pci::PciType0Dev>(dev);
     auto content = text(std::format("{:02x}", type0_dev->get_cardbus_cis()));
     return CreateRegInfoCompat(Type0Cfg::cardbus_cis_ptr, std::move(content), on_click);
 }
 
 static Component
-RegInfoSubsysVIDComp(const pci::PciDevBase *dev, const uint8_t *on_click)
+RegInfoSubsysVIDComp(const pci::PciDevBase *dev, RegVisHandle on_click)
 {
-    auto type0_dev = dynamic_cast<const pci::PciType0Dev *>(dev);
+    auto type0_dev = pci::dev_cast<const pci::PciType0Dev>(dev);
     auto content = text(std::format("[{:04x}] -> {}", type0_dev->get_subsys_vid(),
                                         dev->ids_names_[pci::SUBSYS_NAME].empty() ?
                                         dev->ids_names_[pci::SUBSYS_VENDOR] :
@@ -716,9 +757,9 @@ RegInfoSubsysVIDComp(const pci::PciDevBase *dev, const uint8_t *on_click)
 }
 
 static Component
-RegInfoSubsysIDComp(const pci::PciDevBase *dev, const uint8_t *on_click)
+RegInfoSubsysIDComp(const pci::PciDevBase *dev, RegVisHandle on_click)
 {
-    auto type0_dev = dynamic_cast<const pci::PciType0Dev *>(dev);
+    auto type0_dev = pci::dev_cast<const pci::PciType0Dev>(dev);
     auto content = text(std::format("[{:04x}] -> {}", type0_dev->get_subsys_dev_id(),
                                         dev->ids_names_[pci::SUBSYS_NAME].empty() ?
                                         dev->ids_names_[pci::SUBSYS_VENDOR] :
@@ -728,18 +769,18 @@ RegInfoSubsysIDComp(const pci::PciDevBase *dev, const uint8_t *on_click)
 
 static Component
 RegInfoExpROMComp(const pci::PciDevBase *dev, const compat_reg_type_t reg_type,
-                  const uint8_t *on_click)
+                  RegVisHandle on_click)
 {
     Element content;
     auto exp_rom_bar = dev->get_exp_rom_bar();
 
     if (exp_rom_bar != 0) {
         auto reg_box = GetBarElem(UIBarElemType::Exp, exp_rom_bar);
-        auto [start, end, flags] = dev->resources_[6];
+        const auto &exp_rom_res = dev->GetBarRes(pci::dev_exp_rom_res_idx);
         content = vbox({
             reg_box,
-            text(std::format("phys address: {:#x}", start)),
-            text(std::format("        size: {:#x}", end - start + 1)),
+            text(std::format("phys address: {:#x}", exp_rom_res.phys_addr_)),
+            text(std::format("        size: {:#x}", exp_rom_res.len_)),
             text(std::format("     enabled: {}", (exp_rom_bar & 0x1) ? "▣ " : "☐ "))
         });
     } else {
@@ -758,7 +799,7 @@ RegInfoExpROMComp(const pci::PciDevBase *dev, const compat_reg_type_t reg_type,
 
 static Component
 RegInfoCapPtrComp(const pci::PciDevBase *dev, const compat_reg_type_t reg_type,
-                  const uint8_t *on_click)
+                  RegVisHandle on_click)
 {
     auto cap_ptr = dev->get_cap_ptr();
     cap_ptr &= 0xfc;
@@ -773,7 +814,7 @@ RegInfoCapPtrComp(const pci::PciDevBase *dev, const compat_reg_type_t reg_type,
 
 static Component
 RegInfoItrLineComp(const pci::PciDevBase *dev, const compat_reg_type_t reg_type,
-                   const uint8_t *on_click)
+                   RegVisHandle on_click)
 {
     auto itr_line = dev->get_itr_line();
     auto content = text(std::format("IRQ [{:#x}]", itr_line));
@@ -782,7 +823,7 @@ RegInfoItrLineComp(const pci::PciDevBase *dev, const compat_reg_type_t reg_type,
 
 static Component
 RegInfoItrPinComp(const pci::PciDevBase *dev, const compat_reg_type_t reg_type,
-                   const uint8_t *on_click)
+                   RegVisHandle on_click)
 {
     auto itr_pin = dev->get_itr_pin();
     std::string desc;
@@ -811,62 +852,62 @@ RegInfoItrPinComp(const pci::PciDevBase *dev, const compat_reg_type_t reg_type,
 }
 
 static Component
-RegInfoMinGntComp(const pci::PciDevBase *dev, const uint8_t *on_click)
+RegInfoMinGntComp(const pci::PciDevBase *dev, RegVisHandle on_click)
 {
-    auto type0_dev = dynamic_cast<const pci::PciType0Dev *>(dev);
+    auto type0_dev = pci::dev_cast<const pci::PciType0Dev>(dev);
     auto min_gnt = type0_dev->get_min_gnt();
     auto content = text(std::format("[{:#x}]", min_gnt));
     return CreateRegInfoCompat(Type0Cfg::min_gnt, std::move(content), on_click);
 }
 
 static Component
-RegInfoMaxLatComp(const pci::PciDevBase *dev, const uint8_t *on_click)
+RegInfoMaxLatComp(const pci::PciDevBase *dev, RegVisHandle on_click)
 {
-    auto type0_dev = dynamic_cast<const pci::PciType0Dev *>(dev);
+    auto type0_dev = pci::dev_cast<const pci::PciType0Dev>(dev);
     auto max_lat = type0_dev->get_max_lat();
     auto content = text(std::format("[{:#x}]", max_lat));
     return CreateRegInfoCompat(Type0Cfg::max_lat, std::move(content), on_click);
 }
 
 static Component
-RegInfoPrimBusNumComp(const pci::PciDevBase *dev, const uint8_t *on_click)
+RegInfoPrimBusNumComp(const pci::PciDevBase *dev, RegVisHandle on_click)
 {
-    auto type1_dev = dynamic_cast<const pci::PciType1Dev *>(dev);
+    auto type1_dev = pci::dev_cast<const pci::PciType1Dev>(dev);
     auto prim_bus = type1_dev->get_prim_bus_num();
     auto content = text(std::format("[{:#x}]", prim_bus));
     return CreateRegInfoCompat(Type1Cfg::prim_bus_num, std::move(content), on_click);
 }
 
 static Component
-RegInfoSecBusNumComp(const pci::PciDevBase *dev, const uint8_t *on_click)
+RegInfoSecBusNumComp(const pci::PciDevBase *dev, RegVisHandle on_click)
 {
-    auto type1_dev = dynamic_cast<const pci::PciType1Dev *>(dev);
+    auto type1_dev = pci::dev_cast<const pci::PciType1Dev>(dev);
     auto sec_bus = type1_dev->get_sec_bus_num();
     auto content = text(std::format("[{:#x}]", sec_bus));
     return CreateRegInfoCompat(Type1Cfg::sec_bus_num, std::move(content), on_click);
 }
 
 static Component
-RegInfoSubBusNumComp(const pci::PciDevBase *dev, const uint8_t *on_click)
+RegInfoSubBusNumComp(const pci::PciDevBase *dev, RegVisHandle on_click)
 {
-    auto type1_dev = dynamic_cast<const pci::PciType1Dev *>(dev);
+    auto type1_dev = pci::dev_cast<const pci::PciType1Dev>(dev);
     auto sub_bus = type1_dev->get_sub_bus_num();
     auto content = text(std::format("[{:#x}]", sub_bus));
     return CreateRegInfoCompat(Type1Cfg::sub_bus_num, std::move(content), on_click);
 }
 
 static Component
-RegInfoSecLatTmrComp(const pci::PciDevBase *dev, const uint8_t *on_click)
+RegInfoSecLatTmrComp(const pci::PciDevBase *dev, RegVisHandle on_click)
 {
-    auto type1_dev = dynamic_cast<const pci::PciType1Dev *>(dev);
+    auto type1_dev = pci::dev_cast<const pci::PciType1Dev>(dev);
     auto content = text(std::format("Sec Latency Tmr: {:02x}", type1_dev->get_sec_lat_timer()));
     return CreateRegInfoCompat(Type1Cfg::sec_lat_timer, std::move(content), on_click);
 }
 
 static Component
-RegInfoIOBaseComp(const pci::PciDevBase *dev, const uint8_t *on_click)
+RegInfoIOBaseComp(const pci::PciDevBase *dev, RegVisHandle on_click)
 {
-    auto type1_dev = dynamic_cast<const pci::PciType1Dev *>(dev);
+    auto type1_dev = pci::dev_cast<const pci::PciType1Dev>(dev);
     auto io_base = type1_dev->get_io_base();
     Element content;
     if (io_base == 0) {
@@ -908,9 +949,9 @@ RegInfoIOBaseComp(const pci::PciDevBase *dev, const uint8_t *on_click)
 }
 
 static Component
-RegInfoIOLimitComp(const pci::PciDevBase *dev, const uint8_t *on_click)
+RegInfoIOLimitComp(const pci::PciDevBase *dev, RegVisHandle on_click)
 {
-    auto type1_dev = dynamic_cast<const pci::PciType1Dev *>(dev);
+    auto type1_dev = pci::dev_cast<const pci::PciType1Dev>(dev);
     auto io_base = type1_dev->get_io_base();
     auto io_limit = type1_dev->get_io_limit();
     Element content;
@@ -953,9 +994,9 @@ RegInfoIOLimitComp(const pci::PciDevBase *dev, const uint8_t *on_click)
 }
 
 static Component
-RegInfoUpperIOBaseComp(const pci::PciDevBase *dev, const uint8_t *on_click)
+RegInfoUpperIOBaseComp(const pci::PciDevBase *dev, RegVisHandle on_click)
 {
-    auto type1_dev = dynamic_cast<const pci::PciType1Dev *>(dev);
+    auto type1_dev = pci::dev_cast<const pci::PciType1Dev>(dev);
     auto io_base = type1_dev->get_io_base();
     auto io_base_reg = reinterpret_cast<const RegIOBase *>(&io_base);
 
@@ -987,9 +1028,9 @@ RegInfoUpperIOBaseComp(const pci::PciDevBase *dev, const uint8_t *on_click)
 }
 
 static Component
-RegInfoUpperIOLimitComp(const pci::PciDevBase *dev, const uint8_t *on_click)
+RegInfoUpperIOLimitComp(const pci::PciDevBase *dev, RegVisHandle on_click)
 {
-    auto type1_dev = dynamic_cast<const pci::PciType1Dev *>(dev);
+    auto type1_dev = pci::dev_cast<const pci::PciType1Dev>(dev);
     auto io_limit = type1_dev->get_io_limit();
     auto io_limit_reg = reinterpret_cast<const RegIOLimit *>(&io_limit);
 
@@ -1021,9 +1062,9 @@ RegInfoUpperIOLimitComp(const pci::PciDevBase *dev, const uint8_t *on_click)
 }
 
 static Component
-RegInfoSecStatusComp(const pci::PciDevBase *dev, const uint8_t *on_click)
+RegInfoSecStatusComp(const pci::PciDevBase *dev, RegVisHandle on_click)
 {
-    auto type1_dev = dynamic_cast<const pci::PciType1Dev *>(dev);
+    auto type1_dev = pci::dev_cast<const pci::PciType1Dev>(dev);
     auto sec_status = type1_dev->get_sec_status();
     auto reg = reinterpret_cast<const RegSecStatus *>(&sec_status);
 
@@ -1045,9 +1086,9 @@ RegInfoSecStatusComp(const pci::PciDevBase *dev, const uint8_t *on_click)
 }
 
 static Component
-RegInfoMemoryBaseComp(const pci::PciDevBase *dev, const uint8_t *on_click)
+RegInfoMemoryBaseComp(const pci::PciDevBase *dev, RegVisHandle on_click)
 {
-    auto type1_dev = dynamic_cast<const pci::PciType1Dev *>(dev);
+    auto type1_dev = pci::dev_cast<const pci::PciType1Dev>(dev);
     auto mem_base = type1_dev->get_mem_base();
     Element content;
     if (mem_base == 0) {
@@ -1078,9 +1119,9 @@ RegInfoMemoryBaseComp(const pci::PciDevBase *dev, const uint8_t *on_click)
 }
 
 static Component
-RegInfoMemoryLimitComp(const pci::PciDevBase *dev, const uint8_t *on_click)
+RegInfoMemoryLimitComp(const pci::PciDevBase *dev, RegVisHandle on_click)
 {
-    auto type1_dev = dynamic_cast<const pci::PciType1Dev *>(dev);
+    auto type1_dev = pci::dev_cast<const pci::PciType1Dev>(dev);
     auto mem_base = type1_dev->get_mem_base();
     auto mem_limit = type1_dev->get_mem_limit();
     Element content;
@@ -1112,9 +1153,9 @@ RegInfoMemoryLimitComp(const pci::PciDevBase *dev, const uint8_t *on_click)
 }
 
 static Component
-RegInfoPrefMemBaseComp(const pci::PciDevBase *dev, const uint8_t *on_click)
+RegInfoPrefMemBaseComp(const pci::PciDevBase *dev, RegVisHandle on_click)
 {
-    auto type1_dev = dynamic_cast<const pci::PciType1Dev *>(dev);
+    auto type1_dev = pci::dev_cast<const pci::PciType1Dev>(dev);
     auto pref_mem_base = type1_dev->get_pref_mem_base();
     Element content;
     if (pref_mem_base == 0) {
@@ -1156,9 +1197,9 @@ RegInfoPrefMemBaseComp(const pci::PciDevBase *dev, const uint8_t *on_click)
 }
 
 static Component
-RegInfoPrefMemLimitComp(const pci::PciDevBase *dev, const uint8_t *on_click)
+RegInfoPrefMemLimitComp(const pci::PciDevBase *dev, RegVisHandle on_click)
 {
-    auto type1_dev = dynamic_cast<const pci::PciType1Dev *>(dev);
+    auto type1_dev = pci::dev_cast<const pci::PciType1Dev>(dev);
     auto pref_mem_base = type1_dev->get_pref_mem_base();
     auto pref_mem_limit = type1_dev->get_pref_mem_limit();
     Element content;
@@ -1201,9 +1242,9 @@ RegInfoPrefMemLimitComp(const pci::PciDevBase *dev, const uint8_t *on_click)
 }
 
 static Component
-RegInfoPrefBaseUpperComp(const pci::PciDevBase *dev, const uint8_t *on_click)
+RegInfoPrefBaseUpperComp(const pci::PciDevBase *dev, RegVisHandle on_click)
 {
-    auto type1_dev = dynamic_cast<const pci::PciType1Dev *>(dev);
+    auto type1_dev = pci::dev_cast<const pci::PciType1Dev>(dev);
     auto pref_mem_base = type1_dev->get_pref_mem_base();
     auto pref_mem_base_reg = reinterpret_cast<const RegPrefMemBL *>(&pref_mem_base);
 
@@ -1235,9 +1276,9 @@ RegInfoPrefBaseUpperComp(const pci::PciDevBase *dev, const uint8_t *on_click)
 }
 
 static Component
-RegInfoPrefLimitUpperComp(const pci::PciDevBase *dev, const uint8_t *on_click)
+RegInfoPrefLimitUpperComp(const pci::PciDevBase *dev, RegVisHandle on_click)
 {
-    auto type1_dev = dynamic_cast<const pci::PciType1Dev *>(dev);
+    auto type1_dev = pci::dev_cast<const pci::PciType1Dev>(dev);
     auto pref_mem_limit = type1_dev->get_pref_mem_limit();
     auto pref_mem_limit_reg = reinterpret_cast<const RegPrefMemBL *>(&pref_mem_limit);
 
@@ -1269,9 +1310,9 @@ RegInfoPrefLimitUpperComp(const pci::PciDevBase *dev, const uint8_t *on_click)
 }
 
 static Component
-RegInfoBridgeCtrlComp(const pci::PciDevBase *dev, const uint8_t *on_click)
+RegInfoBridgeCtrlComp(const pci::PciDevBase *dev, RegVisHandle on_click)
 {
-    auto type1_dev = dynamic_cast<const pci::PciType1Dev *>(dev);
+    auto type1_dev = pci::dev_cast<const pci::PciType1Dev>(dev);
     auto bridge_ctrl = type1_dev->get_bridge_ctl();
     auto reg = reinterpret_cast<const RegBridgeCtl *>(&bridge_ctrl);
 
@@ -1296,7 +1337,7 @@ RegInfoBridgeCtrlComp(const pci::PciDevBase *dev, const uint8_t *on_click)
 // Create a component showing detailed info about the register in PCI-compatible
 // configuration region (first 64 bytes)
 static Component
-CompatRegInfoComponent(const pci::PciDevBase *dev, const Type0Cfg reg_type, const uint8_t *on_click)
+CompatRegInfoComponent(const pci::PciDevBase *dev, const Type0Cfg reg_type, RegVisHandle on_click)
 {
     switch (reg_type) {
     case Type0Cfg::vid:
@@ -1351,7 +1392,7 @@ CompatRegInfoComponent(const pci::PciDevBase *dev, const Type0Cfg reg_type, cons
 }
 
 static Component
-CompatRegInfoComponent(const pci::PciDevBase *dev, const Type1Cfg reg_type, const uint8_t *on_click)
+CompatRegInfoComponent(const pci::PciDevBase *dev, const Type1Cfg reg_type, RegVisHandle on_click)
 {
     switch (reg_type) {
     case Type1Cfg::vid:
@@ -1423,7 +1464,7 @@ CompatRegInfoComponent(const pci::PciDevBase *dev, const Type1Cfg reg_type, cons
 }
 
 capability_comp_ctx
-GetCompatHeaderRegsComponents(const pci::PciDevBase *dev, std::vector<uint8_t> &vis_state_vt)
+GetCompatHeaderRegsComponents(const pci::PciDevBase *dev, RegVisState &vis_state_vt)
 {
     Components upper, lower;
     size_t i = vis_state_vt.size();
@@ -1444,245 +1485,245 @@ GetCompatHeaderRegsComponents(const pci::PciDevBase *dev, std::vector<uint8_t> &
 
     // Some registers in PCI-compatible config space are identical for both type 0 and type 1 devices
     upper.push_back(Container::Horizontal({
-                        RegButtonComp(ui::RegTypeLabel(Type0Cfg::dev_id), &vis_state_vt[i++]),
-                        RegButtonComp(ui::RegTypeLabel(Type0Cfg::vid),    &vis_state_vt[i++])
+                        RegButtonComp(ui::RegTypeLabel(Type0Cfg::dev_id), vis_state_vt.Handle(i++)),
+                        RegButtonComp(ui::RegTypeLabel(Type0Cfg::vid),    vis_state_vt.Handle(i++))
                       }));
 
-    lower.push_back(CompatRegInfoComponent(dev, Type0Cfg::dev_id, &vis_state_vt[i - 2]));
-    lower.push_back(CompatRegInfoComponent(dev, Type0Cfg::vid,    &vis_state_vt[i - 1]));
+    lower.push_back(CompatRegInfoComponent(dev, Type0Cfg::dev_id, vis_state_vt.Handle(i - 2)));
+    lower.push_back(CompatRegInfoComponent(dev, Type0Cfg::vid,    vis_state_vt.Handle(i - 1)));
 
     upper.push_back(Container::Horizontal({
-                        RegButtonComp(ui::RegTypeLabel(Type0Cfg::status),  &vis_state_vt[i++]),
-                        RegButtonComp(ui::RegTypeLabel(Type0Cfg::command), &vis_state_vt[i++])
+                        RegButtonComp(ui::RegTypeLabel(Type0Cfg::status),  vis_state_vt.Handle(i++)),
+                        RegButtonComp(ui::RegTypeLabel(Type0Cfg::command), vis_state_vt.Handle(i++))
                      }));
 
-    lower.push_back(CompatRegInfoComponent(dev, Type0Cfg::status,  &vis_state_vt[i - 2]));
-    lower.push_back(CompatRegInfoComponent(dev, Type0Cfg::command, &vis_state_vt[i - 1]));
+    lower.push_back(CompatRegInfoComponent(dev, Type0Cfg::status,  vis_state_vt.Handle(i - 2)));
+    lower.push_back(CompatRegInfoComponent(dev, Type0Cfg::command, vis_state_vt.Handle(i - 1)));
 
     upper.push_back(Container::Horizontal({
-                        RegButtonComp(ui::RegTypeLabel(Type0Cfg::class_code),   &vis_state_vt[i++]),
+                        RegButtonComp(ui::RegTypeLabel(Type0Cfg::class_code),   vis_state_vt.Handle(i++)),
                         Container::Horizontal({
-                            RegButtonComp(ui::RegTypeLabel(Type0Cfg::revision), &vis_state_vt[i++])
+                            RegButtonComp(ui::RegTypeLabel(Type0Cfg::revision), vis_state_vt.Handle(i++))
                         })
                      }));
 
-    lower.push_back(CompatRegInfoComponent(dev, Type0Cfg::class_code, &vis_state_vt[i - 2]));
-    lower.push_back(CompatRegInfoComponent(dev, Type0Cfg::revision,   &vis_state_vt[i - 1]));
+    lower.push_back(CompatRegInfoComponent(dev, Type0Cfg::class_code, vis_state_vt.Handle(i - 2)));
+    lower.push_back(CompatRegInfoComponent(dev, Type0Cfg::revision,   vis_state_vt.Handle(i - 1)));
 
     upper.push_back(Container::Horizontal({
-                        RegButtonComp(ui::RegTypeLabel(Type0Cfg::bist),            &vis_state_vt[i++]),
-                        RegButtonComp(ui::RegTypeLabel(Type0Cfg::header_type),     &vis_state_vt[i++]),
-                        RegButtonComp(ui::RegTypeLabel(Type0Cfg::latency_timer),   &vis_state_vt[i++]),
-                        RegButtonComp(ui::RegTypeLabel(Type0Cfg::cache_line_size), &vis_state_vt[i++])
+                        RegButtonComp(ui::RegTypeLabel(Type0Cfg::bist),            vis_state_vt.Handle(i++)),
+                        RegButtonComp(ui::RegTypeLabel(Type0Cfg::header_type),     vis_state_vt.Handle(i++)),
+                        RegButtonComp(ui::RegTypeLabel(Type0Cfg::latency_timer),   vis_state_vt.Handle(i++)),
+                        RegButtonComp(ui::RegTypeLabel(Type0Cfg::cache_line_size), vis_state_vt.Handle(i++))
                      }));
 
     lower.push_back(CompatRegInfoComponent(dev, Type0Cfg::bist,
-                                                                  &vis_state_vt[i - 4]));
+                                                                  vis_state_vt.Handle(i - 4)));
     lower.push_back(CompatRegInfoComponent(dev, Type0Cfg::header_type,
-                                                                  &vis_state_vt[i - 3]));
+                                                                  vis_state_vt.Handle(i - 3)));
     lower.push_back(CompatRegInfoComponent(dev, Type0Cfg::latency_timer,
-                                                                  &vis_state_vt[i - 2]));
+                                                                  vis_state_vt.Handle(i - 2)));
     lower.push_back(CompatRegInfoComponent(dev, Type0Cfg::cache_line_size,
-                                                                  &vis_state_vt[i - 1]));
+                                                                  vis_state_vt.Handle(i - 1)));
 
     if (dev->type_ == pci::pci_dev_type::TYPE0) {
         // BARs
         upper.push_back(Container::Horizontal({
-                            RegButtonComp(ui::RegTypeLabel(Type0Cfg::bar0), &vis_state_vt[i])
+                            RegButtonComp(ui::RegTypeLabel(Type0Cfg::bar0), vis_state_vt.Handle(i))
                          }));
-        lower.push_back(CompatRegInfoComponent(dev, Type0Cfg::bar0, &vis_state_vt[i++]));
+        lower.push_back(CompatRegInfoComponent(dev, Type0Cfg::bar0, vis_state_vt.Handle(i++)));
 
         upper.push_back(Container::Horizontal({
-                            RegButtonComp(ui::RegTypeLabel(Type0Cfg::bar1), &vis_state_vt[i])
+                            RegButtonComp(ui::RegTypeLabel(Type0Cfg::bar1), vis_state_vt.Handle(i))
                          }));
-        lower.push_back(CompatRegInfoComponent(dev, Type0Cfg::bar1, &vis_state_vt[i++]));
+        lower.push_back(CompatRegInfoComponent(dev, Type0Cfg::bar1, vis_state_vt.Handle(i++)));
 
         upper.push_back(Container::Horizontal({
-                            RegButtonComp(ui::RegTypeLabel(Type0Cfg::bar2), &vis_state_vt[i])
+                            RegButtonComp(ui::RegTypeLabel(Type0Cfg::bar2), vis_state_vt.Handle(i))
                          }));
-        lower.push_back(CompatRegInfoComponent(dev, Type0Cfg::bar2, &vis_state_vt[i++]));
+        lower.push_back(CompatRegInfoComponent(dev, Type0Cfg::bar2, vis_state_vt.Handle(i++)));
 
         upper.push_back(Container::Horizontal({
-                            RegButtonComp(ui::RegTypeLabel(Type0Cfg::bar3), &vis_state_vt[i])
+                            RegButtonComp(ui::RegTypeLabel(Type0Cfg::bar3), vis_state_vt.Handle(i))
                          }));
-        lower.push_back(CompatRegInfoComponent(dev, Type0Cfg::bar3, &vis_state_vt[i++]));
+        lower.push_back(CompatRegInfoComponent(dev, Type0Cfg::bar3, vis_state_vt.Handle(i++)));
 
         upper.push_back(Container::Horizontal({
-                            RegButtonComp(ui::RegTypeLabel(Type0Cfg::bar4), &vis_state_vt[i])
+                            RegButtonComp(ui::RegTypeLabel(Type0Cfg::bar4), vis_state_vt.Handle(i))
                          }));
-        lower.push_back(CompatRegInfoComponent(dev, Type0Cfg::bar4, &vis_state_vt[i++]));
+        lower.push_back(CompatRegInfoComponent(dev, Type0Cfg::bar4, vis_state_vt.Handle(i++)));
 
         upper.push_back(Container::Horizontal({
-                            RegButtonComp(ui::RegTypeLabel(Type0Cfg::bar5), &vis_state_vt[i])
+                            RegButtonComp(ui::RegTypeLabel(Type0Cfg::bar5), vis_state_vt.Handle(i))
                          }));
-        lower.push_back(CompatRegInfoComponent(dev, Type0Cfg::bar5, &vis_state_vt[i++]));
+        lower.push_back(CompatRegInfoComponent(dev, Type0Cfg::bar5, vis_state_vt.Handle(i++)));
 
         // Cardbus CIS ptr
         upper.push_back(Container::Horizontal({
-                            RegButtonComp(ui::RegTypeLabel(Type0Cfg::cardbus_cis_ptr), &vis_state_vt[i])
+                            RegButtonComp(ui::RegTypeLabel(Type0Cfg::cardbus_cis_ptr), vis_state_vt.Handle(i))
                          }));
         lower.push_back(CompatRegInfoComponent(dev, Type0Cfg::cardbus_cis_ptr,
-                                                      &vis_state_vt[i++]));
+                                                      vis_state_vt.Handle(i++)));
 
         upper.push_back(Container::Horizontal({
-                            RegButtonComp(ui::RegTypeLabel(Type0Cfg::subsys_dev_id), &vis_state_vt[i++]),
-                            RegButtonComp(ui::RegTypeLabel(Type0Cfg::subsys_vid),    &vis_state_vt[i++])
+                            RegButtonComp(ui::RegTypeLabel(Type0Cfg::subsys_dev_id), vis_state_vt.Handle(i++)),
+                            RegButtonComp(ui::RegTypeLabel(Type0Cfg::subsys_vid),    vis_state_vt.Handle(i++))
                          }));
 
         lower.push_back(CompatRegInfoComponent(dev, Type0Cfg::subsys_dev_id,
-                                                      &vis_state_vt[i - 2]));
+                                                      vis_state_vt.Handle(i - 2)));
         lower.push_back(CompatRegInfoComponent(dev, Type0Cfg::subsys_vid,
-                                                      &vis_state_vt[i - 1]));
+                                                      vis_state_vt.Handle(i - 1)));
 
         upper.push_back(Container::Horizontal({
-                            RegButtonComp(ui::RegTypeLabel(Type0Cfg::exp_rom_bar), &vis_state_vt[i])
+                            RegButtonComp(ui::RegTypeLabel(Type0Cfg::exp_rom_bar), vis_state_vt.Handle(i))
                          }));
         lower.push_back(CompatRegInfoComponent(dev, Type0Cfg::exp_rom_bar,
-                                                      &vis_state_vt[i++]));
+                                                      vis_state_vt.Handle(i++)));
 
         upper.push_back(Container::Horizontal({
                             RegButtonComp("Rsvd (0x35)"),
                             Container::Horizontal({
-                                RegButtonComp(ui::RegTypeLabel(Type0Cfg::cap_ptr), &vis_state_vt[i++])
+                                RegButtonComp(ui::RegTypeLabel(Type0Cfg::cap_ptr), vis_state_vt.Handle(i++))
                             })
                          }));
 
         lower.push_back(CompatRegInfoComponent(dev, Type0Cfg::cap_ptr,
-                                                      &vis_state_vt[i - 1]));
+                                                      vis_state_vt.Handle(i - 1)));
 
         upper.push_back(Container::Horizontal({
                             RegButtonComp("Rsvd (0x38)")
                          }));
 
         upper.push_back(Container::Horizontal({
-                            RegButtonComp(ui::RegTypeLabel(Type0Cfg::max_lat),  &vis_state_vt[i++]),
-                            RegButtonComp(ui::RegTypeLabel(Type0Cfg::min_gnt),  &vis_state_vt[i++]),
-                            RegButtonComp(ui::RegTypeLabel(Type0Cfg::itr_pin),  &vis_state_vt[i++]),
-                            RegButtonComp(ui::RegTypeLabel(Type0Cfg::itr_line), &vis_state_vt[i++])
+                            RegButtonComp(ui::RegTypeLabel(Type0Cfg::max_lat),  vis_state_vt.Handle(i++)),
+                            RegButtonComp(ui::RegTypeLabel(Type0Cfg::min_gnt),  vis_state_vt.Handle(i++)),
+                            RegButtonComp(ui::RegTypeLabel(Type0Cfg::itr_pin),  vis_state_vt.Handle(i++)),
+                            RegButtonComp(ui::RegTypeLabel(Type0Cfg::itr_line), vis_state_vt.Handle(i++))
                          }));
 
         lower.push_back(CompatRegInfoComponent(dev, Type0Cfg::max_lat,
-                                                                      &vis_state_vt[i - 4]));
+                                                                      vis_state_vt.Handle(i - 4)));
         lower.push_back(CompatRegInfoComponent(dev, Type0Cfg::min_gnt,
-                                                                      &vis_state_vt[i - 3]));
+                                                                      vis_state_vt.Handle(i - 3)));
         lower.push_back(CompatRegInfoComponent(dev, Type0Cfg::itr_pin,
-                                                                      &vis_state_vt[i - 2]));
+                                                                      vis_state_vt.Handle(i - 2)));
         lower.push_back(CompatRegInfoComponent(dev, Type0Cfg::itr_line,
-                                                                      &vis_state_vt[i - 1]));
+                                                                      vis_state_vt.Handle(i - 1)));
     } else { // type 1
         upper.push_back(Container::Horizontal({
-                            RegButtonComp(ui::RegTypeLabel(Type1Cfg::bar0), &vis_state_vt[i])
+                            RegButtonComp(ui::RegTypeLabel(Type1Cfg::bar0), vis_state_vt.Handle(i))
                          }));
-        lower.push_back(CompatRegInfoComponent(dev, Type1Cfg::bar0, &vis_state_vt[i++]));
+        lower.push_back(CompatRegInfoComponent(dev, Type1Cfg::bar0, vis_state_vt.Handle(i++)));
 
         upper.push_back(Container::Horizontal({
-                            RegButtonComp(ui::RegTypeLabel(Type1Cfg::bar1), &vis_state_vt[i])
+                            RegButtonComp(ui::RegTypeLabel(Type1Cfg::bar1), vis_state_vt.Handle(i))
                          }));
-        lower.push_back(CompatRegInfoComponent(dev, Type1Cfg::bar1, &vis_state_vt[i++]));
+        lower.push_back(CompatRegInfoComponent(dev, Type1Cfg::bar1, vis_state_vt.Handle(i++)));
 
         upper.push_back(Container::Horizontal({
-                            RegButtonComp(ui::RegTypeLabel(Type1Cfg::sec_lat_timer), &vis_state_vt[i++]),
-                            RegButtonComp(ui::RegTypeLabel(Type1Cfg::sub_bus_num),   &vis_state_vt[i++]),
-                            RegButtonComp(ui::RegTypeLabel(Type1Cfg::sec_bus_num),   &vis_state_vt[i++]),
-                            RegButtonComp(ui::RegTypeLabel(Type1Cfg::prim_bus_num),  &vis_state_vt[i++])
+                            RegButtonComp(ui::RegTypeLabel(Type1Cfg::sec_lat_timer), vis_state_vt.Handle(i++)),
+                            RegButtonComp(ui::RegTypeLabel(Type1Cfg::sub_bus_num),   vis_state_vt.Handle(i++)),
+                            RegButtonComp(ui::RegTypeLabel(Type1Cfg::sec_bus_num),   vis_state_vt.Handle(i++)),
+                            RegButtonComp(ui::RegTypeLabel(Type1Cfg::prim_bus_num),  vis_state_vt.Handle(i++))
                          }));
 
         lower.push_back(CompatRegInfoComponent(dev, Type1Cfg::sec_lat_timer,
-                                                                      &vis_state_vt[i - 4]));
+                                                                      vis_state_vt.Handle(i - 4)));
         lower.push_back(CompatRegInfoComponent(dev, Type1Cfg::sub_bus_num,
-                                                                      &vis_state_vt[i - 3]));
+                                                                      vis_state_vt.Handle(i - 3)));
         lower.push_back(CompatRegInfoComponent(dev, Type1Cfg::sec_bus_num,
-                                                                      &vis_state_vt[i - 2]));
+                                                                      vis_state_vt.Handle(i - 2)));
         lower.push_back(CompatRegInfoComponent(dev, Type1Cfg::prim_bus_num,
-                                                                      &vis_state_vt[i - 1]));
+                                                                      vis_state_vt.Handle(i - 1)));
 
         upper.push_back(Container::Horizontal({
-                            RegButtonComp(ui::RegTypeLabel(Type1Cfg::sec_status), &vis_state_vt[i++]),
+                            RegButtonComp(ui::RegTypeLabel(Type1Cfg::sec_status), vis_state_vt.Handle(i++)),
                             Container::Horizontal({
-                                RegButtonComp(ui::RegTypeLabel(Type1Cfg::io_limit), &vis_state_vt[i++]),
-                                RegButtonComp(ui::RegTypeLabel(Type1Cfg::io_base), &vis_state_vt[i++])
+                                RegButtonComp(ui::RegTypeLabel(Type1Cfg::io_limit), vis_state_vt.Handle(i++)),
+                                RegButtonComp(ui::RegTypeLabel(Type1Cfg::io_base), vis_state_vt.Handle(i++))
                             })
                          }));
 
         lower.push_back(CompatRegInfoComponent(dev, Type1Cfg::sec_status,
-                                                                      &vis_state_vt[i - 3]));
+                                                                      vis_state_vt.Handle(i - 3)));
         lower.push_back(CompatRegInfoComponent(dev, Type1Cfg::io_limit,
-                                                                      &vis_state_vt[i - 2]));
+                                                                      vis_state_vt.Handle(i - 2)));
         lower.push_back(CompatRegInfoComponent(dev, Type1Cfg::io_base,
-                                                                      &vis_state_vt[i - 1]));
+                                                                      vis_state_vt.Handle(i - 1)));
 
         upper.push_back(Container::Horizontal({
-                            RegButtonComp(ui::RegTypeLabel(Type1Cfg::mem_limit), &vis_state_vt[i++]),
-                            RegButtonComp(ui::RegTypeLabel(Type1Cfg::mem_base), &vis_state_vt[i++])
+                            RegButtonComp(ui::RegTypeLabel(Type1Cfg::mem_limit), vis_state_vt.Handle(i++)),
+                            RegButtonComp(ui::RegTypeLabel(Type1Cfg::mem_base), vis_state_vt.Handle(i++))
                          }));
 
         lower.push_back(CompatRegInfoComponent(dev, Type1Cfg::mem_limit,
-                                                      &vis_state_vt[i - 2]));
+                                                      vis_state_vt.Handle(i - 2)));
         lower.push_back(CompatRegInfoComponent(dev, Type1Cfg::mem_base,
-                                                      &vis_state_vt[i - 1]));
+                                                      vis_state_vt.Handle(i - 1)));
 
         upper.push_back(Container::Horizontal({
-                            RegButtonComp(ui::RegTypeLabel(Type1Cfg::pref_mem_limit), &vis_state_vt[i++]),
-                            RegButtonComp(ui::RegTypeLabel(Type1Cfg::pref_mem_base),  &vis_state_vt[i++])
+                            RegButtonComp(ui::RegTypeLabel(Type1Cfg::pref_mem_limit), vis_state_vt.Handle(i++)),
+                            RegButtonComp(ui::RegTypeLabel(Type1Cfg::pref_mem_base),  vis_state_vt.Handle(i++))
                          }));
 
         lower.push_back(CompatRegInfoComponent(dev, Type1Cfg::pref_mem_limit,
-                                                      &vis_state_vt[i - 2]));
+                                                      vis_state_vt.Handle(i - 2)));
         lower.push_back(CompatRegInfoComponent(dev, Type1Cfg::pref_mem_base,
-                                                      &vis_state_vt[i - 1]));
+                                                      vis_state_vt.Handle(i - 1)));
 
         upper.push_back(Container::Horizontal({
-                            RegButtonComp(ui::RegTypeLabel(Type1Cfg::pref_base_upper), &vis_state_vt[i])
+                            RegButtonComp(ui::RegTypeLabel(Type1Cfg::pref_base_upper), vis_state_vt.Handle(i))
                          }));
         lower.push_back(CompatRegInfoComponent(dev, Type1Cfg::pref_base_upper,
-                                                      &vis_state_vt[i++]));
+                                                      vis_state_vt.Handle(i++)));
 
         upper.push_back(Container::Horizontal({
-                            RegButtonComp(ui::RegTypeLabel(Type1Cfg::pref_limit_upper), &vis_state_vt[i])
+                            RegButtonComp(ui::RegTypeLabel(Type1Cfg::pref_limit_upper), vis_state_vt.Handle(i))
                          }));
         lower.push_back(CompatRegInfoComponent(dev, Type1Cfg::pref_limit_upper,
-                                                      &vis_state_vt[i++]));
+                                                      vis_state_vt.Handle(i++)));
 
         upper.push_back(Container::Horizontal({
-                            RegButtonComp(ui::RegTypeLabel(Type1Cfg::io_limit_upper), &vis_state_vt[i++]),
-                            RegButtonComp(ui::RegTypeLabel(Type1Cfg::io_base_upper),  &vis_state_vt[i++])
+                            RegButtonComp(ui::RegTypeLabel(Type1Cfg::io_limit_upper), vis_state_vt.Handle(i++)),
+                            RegButtonComp(ui::RegTypeLabel(Type1Cfg::io_base_upper),  vis_state_vt.Handle(i++))
                          }));
 
         lower.push_back(CompatRegInfoComponent(dev, Type1Cfg::io_limit_upper,
-                                                      &vis_state_vt[i - 2]));
+                                                      vis_state_vt.Handle(i - 2)));
         lower.push_back(CompatRegInfoComponent(dev, Type1Cfg::io_base_upper,
-                                                      &vis_state_vt[i - 1]));
+                                                      vis_state_vt.Handle(i - 1)));
 
         upper.push_back(Container::Horizontal({
                             RegButtonComp("Rsvd (0x35)"),
                             Container::Horizontal({
-                                RegButtonComp(ui::RegTypeLabel(Type1Cfg::cap_ptr), &vis_state_vt[i++])
+                                RegButtonComp(ui::RegTypeLabel(Type1Cfg::cap_ptr), vis_state_vt.Handle(i++))
                             })
                          }));
 
         lower.push_back(CompatRegInfoComponent(dev, Type1Cfg::cap_ptr,
-                                                      &vis_state_vt[i - 1]));
+                                                      vis_state_vt.Handle(i - 1)));
 
         upper.push_back(Container::Horizontal({
-                            RegButtonComp(ui::RegTypeLabel(Type1Cfg::exp_rom_bar), &vis_state_vt[i])
+                            RegButtonComp(ui::RegTypeLabel(Type1Cfg::exp_rom_bar), vis_state_vt.Handle(i))
                          }));
         lower.push_back(CompatRegInfoComponent(dev, Type1Cfg::exp_rom_bar,
-                                                      &vis_state_vt[i++]));
+                                                      vis_state_vt.Handle(i++)));
 
         upper.push_back(Container::Horizontal({
-                            RegButtonComp(ui::RegTypeLabel(Type1Cfg::bridge_ctl), &vis_state_vt[i++]),
+                            RegButtonComp(ui::RegTypeLabel(Type1Cfg::bridge_ctl), vis_state_vt.Handle(i++)),
                             Container::Horizontal({
-                                RegButtonComp(ui::RegTypeLabel(Type1Cfg::itr_pin), &vis_state_vt[i++]),
-                                RegButtonComp(ui::RegTypeLabel(Type1Cfg::itr_line), &vis_state_vt[i++])
+                                RegButtonComp(ui::RegTypeLabel(Type1Cfg::itr_pin), vis_state_vt.Handle(i++)),
+                                RegButtonComp(ui::RegTypeLabel(Type1Cfg::itr_line), vis_state_vt.Handle(i++))
                             })
                          }));
 
         lower.push_back(CompatRegInfoComponent(dev, Type1Cfg::bridge_ctl,
-                                               &vis_state_vt[i - 3]));
+                                               vis_state_vt.Handle(i - 3)));
         lower.push_back(CompatRegInfoComponent(dev, Type1Cfg::itr_pin,
-                                               &vis_state_vt[i - 2]));
+                                               vis_state_vt.Handle(i - 2)));
         lower.push_back(CompatRegInfoComponent(dev, Type1Cfg::itr_line,
-                                               &vis_state_vt[i - 1]));
+                                               vis_state_vt.Handle(i - 1)));
     }
 
     return {std::move(upper), std::move(lower)};
@@ -1691,15 +1732,15 @@ GetCompatHeaderRegsComponents(const pci::PciDevBase *dev, std::vector<uint8_t> &
 Component
 CapDelimComp(const pci::CapDesc &cap)
 {
-    auto type = std::get<0>(cap);
-    auto off = std::get<3>(cap);
+    auto type = cap.type();
+    auto off = cap.off();
 
     std::string label;
     if (type == pci::CapType::compat) {
-        auto compat_cap_type = CompatCapID {std::get<1>(cap)};
+        auto compat_cap_type = CompatCapID{cap.id()};
         label = std::format(">>> {} [compat] ", CompatCapName(compat_cap_type));
     } else {
-        auto ext_cap_type = ExtCapID {std::get<1>(cap)};
+        auto ext_cap_type = ExtCapID {cap.id()};
         label = std::format(">>> {} [extended] ", ExtCapName(ext_cap_type));
     }
 
@@ -1789,7 +1830,7 @@ EmptyCapRegComp(const std::string desc)
 
 Component
 CreateCapRegInfo(const std::string &cap_desc, const std::string &cap_reg, Element content,
-                 const uint8_t *on_click)
+                 RegVisHandle on_click)
 {
     auto title = text(std::format("{} -> {}", cap_desc, cap_reg)) |
                              inverted | align_right | bold;
@@ -5,18 +5,19 @@
 
 #include "pci_dev.h"
 #include "pci_regs.h"
+#include "reg_vis_state.h"
 #include <ftxui/component/component.hpp>
 
 namespace ui {
 
 // XXX: This is essentialy the same as ftxui::ButtonBase with the couple of differences:
 // - it can track pressed/released state the same way ftxui::Checkbox does.
-// - it can be switched on and off externally by modifying @ena_flag_ flag
+// - it can be switched on and off externally by modifying the flag @ena_flag_ refers to
 // TODO: merge to mainline
 class PushPullButton : public ftxui::ComponentBase, public ftxui::ButtonOption
 {
 public:
-    explicit PushPullButton(ButtonOption option, uint8_t *on_click)
+    explicit PushPullButton(ButtonOption option, RegVisHandle on_click)
         : ButtonOption(std::move(option)),
           ena_flag_(on_click)
     {}
@@ -34,7 +35,7 @@ public:
 private:
     bool is_pressed_ = false;
     bool mouse_hover_ = false;
-    uint8_t *ena_flag_;
+    RegVisHandle ena_flag_;
     ftxui::Box box_;
     ftxui::ButtonOption option_;
     float animation_background_ = 0;
@@ -45,7 +46,7 @@ private:
       ftxui::animation::Animator(&animation_foreground_);
 };
 
-ftxui::Component RegButtonComp(std::string label, uint8_t *on_click = nullptr);
+ftxui::Component RegButtonComp(std::string label, RegVisHandle on_click = {});
 
 // Compact register field element
 ftxui::Element
@@ -57,9 +58,9 @@ ftxui::Element
 RegFieldVerbElem(const uint8_t fb, const uint8_t lb, std::string desc,
                  uint16_t val);
 
-// Create component out of Element, which would only be shown if @on_click == 1
+// Create component out of Element, which would only be shown if @on_click flag is set
 ftxui::Component
-GetCompMaybe(ftxui::Element elem, const uint8_t *on_click);
+GetCompMaybe(ftxui::Element elem, RegVisHandle on_click);
 
 // Create an element representing a hex dump of some buffer
 ftxui::Element
@@ -77,7 +78,7 @@ typedef std::pair<ftxui::Components, ftxui::Components> capability_comp_ctx;
 
 // Create components for type0/type1 config space header
 capability_comp_ctx
-GetCompatHeaderRegsComponents(const pci::PciDevBase *dev, std::vector<uint8_t> &vis_state_vt);
+GetCompatHeaderRegsComponents(const pci::PciDevBase *dev, RegVisState &vis_state_vt);
 
 // Create particular capability delimiter
 ftxui::Component
@@ -99,6 +100,6 @@ EmptyCapRegComp(const std::string desc);
 // Create component which incapsulates verbose register information within capability
 ftxui::Component
 CreateCapRegInfo(const std::string &cap_desc, const std::string &cap_reg,
-                 ftxui::Element content, const uint8_t *on_click);
+                 ftxui::Element content, RegVisHandle on_click);
 
 } // namespace ui
@@ -17,7 +17,7 @@ namespace ui {
 
 static capability_comp_ctx
 CompatVendorSpecCap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
-                    std::vector<uint8_t> &vis)
+                    RegVisState &vis)
 {
     Components upper, lower;
     constexpr auto reg_per_cap = 1;
@@ -25,13 +25,13 @@ CompatVendorSpecCap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
 
     std::ranges::fill_n(std::back_inserter(vis), reg_per_cap, 0);
 
-    auto off = std::get<3>(cap);
+    auto off = cap.off();
     auto vspec = reinterpret_cast<const CompatCapVendorSpec *>(dev->cfg_space_.get() + off);
     auto vspec_buf = reinterpret_cast<const uint8_t *>(dev->cfg_space_.get() + off + sizeof(*vspec));
 
     upper.push_back(CapDelimComp(cap));
     upper.push_back(Container::Horizontal({
-                        RegButtonComp("Vendor-Specific", &vis[i]),
+                        RegButtonComp("Vendor-Specific", vis.Handle(i)),
                         CapHdrComp(vspec->hdr)
                     }));
 
@@ -51,7 +51,7 @@ CompatVendorSpecCap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
                                  (dev->cfg_space_.get() + off);
             if (virtio_struct->cfg_type > e_to_type(virtio::VirtIOCapID::cap_id_max)) {
                 logger.log(Verbosity::WARN, "{}: unexpected virtio cfg type ({}) in vendor spec cap (off {:02x})",
-                            dev->dev_id_str_, virtio_struct->cfg_type, off);
+                            dev->DevIdStr(), virtio_struct->cfg_type, off);
             } else {
                 content_elems.push_back(separatorEmpty());
                 auto vhdr = text("[VirtIO]") | bold | bgcolor(Color::Blue) | color(Color::Grey15);
@@ -76,30 +76,30 @@ CompatVendorSpecCap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
     auto content_elem = vbox(content_elems);
 
     lower.push_back(CreateCapRegInfo(std::format("[compat][{:#02x}] Vendor-Specific", off),
-                                     "Info", std::move(content_elem), &vis[i]));
+                                     "Info", std::move(content_elem), vis.Handle(i)));
 
     return {std::move(upper), std::move(lower)};
 }
 
 static capability_comp_ctx
 CompatPMCap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
-            std::vector<uint8_t> &vis)
+            RegVisState &vis)
 {
     Components upper, lower;
     constexpr auto reg_per_cap = 2;
     size_t i = vis.size();
     std::ranges::fill_n(std::back_inserter(vis), reg_per_cap, 0);
 
-    auto off = std::get<3>(cap);
+    auto off = cap.off();
     auto pm_cap = reinterpret_cast<const PciPMCap *>(dev->cfg_space_.get() + off);
 
     upper.push_back(CapDelimComp(cap));
     upper.push_back(Container::Horizontal({
-                        RegButtonComp("PM Capabilities +0x2", &vis[i++]),
+                        RegButtonComp("PM Capabilities +0x2", vis.Handle(i++)),
                         CapHdrComp(pm_cap->hdr)
                     }));
     upper.push_back(Container::Horizontal({
-                        RegButtonComp("PM Ctrl/Status +0x4", &vis[i++])
+                        RegButtonComp("PM Ctrl/Status +0x4", vis.Handle(i++))
                     }));
 
     std::array<uint16_t, 8> aux_max_current {0, 55, 100, 160, 220, 270, 320, 375};
@@ -141,31 +141,31 @@ CompatPMCap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
     });
 
     lower.push_back(CreateCapRegInfo(std::format("[compat][{:#02x}] Power Management", off),
-                                     "PM Capabilities +0x2", std::move(pm_cap_content), &vis[i - 2]));
+                                     "PM Capabilities +0x2", std::move(pm_cap_content), vis.Handle(i - 2)));
     lower.push_back(CreateCapRegInfo(std::format("[compat][{:#02x}] Power Management", off),
                                      "PM Ctrl/Status +0x4", std::move(pm_ctrl_stat_content),
-                                     &vis[i - 1]));
+                                     vis.Handle(i - 1)));
 
     return {std::move(upper), std::move(lower)};
 }
 
 static capability_comp_ctx
 CompatMSICap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
-             std::vector<uint8_t> &vis)
+             RegVisState &vis)
 {
     Components upper, lower;
     //constexpr auto reg_per_cap = 2;
     size_t i = vis.size();
     std::ranges::fill_n(std::back_inserter(vis), 1, 0);
 
-    auto off = std::get<3>(cap);
+    auto off = cap.off();
     auto msi_cap_hdr = reinterpret_cast<const CompatCapHdr *>(dev->cfg_space_.get() + off);
     auto msi_msg_ctrl_reg = reinterpret_cast<const RegMSIMsgCtrl *>
                             (dev->cfg_space_.get() + off + 0x2);
 
     upper.push_back(CapDelimComp(cap));
     upper.push_back(Container::Horizontal({
-                        RegButtonComp("Message Control +0x2", &vis[i]),
+                        RegButtonComp("Message Control +0x2", vis.Handle(i)),
                         CapHdrComp(*msi_cap_hdr)
                     }));
 
@@ -187,7 +187,7 @@ CompatMSICap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
     });
 
     lower.push_back(CreateCapRegInfo(std::format("[compat][{:#02x}] MSI", off),
-                                     "Message Control +0x2", std::move(msi_mc_content), &vis[i++]));
+                                     "Message Control +0x2", std::move(msi_mc_content), vis.Handle(i++)));
 
     // Add other components depending on the type of MSI capability
     if (msi_msg_ctrl_reg->addr_64_bit_capable) {
@@ -196,10 +196,10 @@ CompatMSICap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
         auto msg_addr_upper = *reinterpret_cast<const uint32_t *>(dev->cfg_space_.get() + off + 0x8);
 
         upper.push_back(Container::Horizontal({
-                            RegButtonComp("Message Address lower 32 bits +0x4", &vis[i++])
+                            RegButtonComp("Message Address lower 32 bits +0x4", vis.Handle(i++))
                         }));
         upper.push_back(Container::Horizontal({
-                            RegButtonComp("Message Address upper 32 bits +0x8", &vis[i++])
+                            RegButtonComp("Message Address upper 32 bits +0x8", vis.Handle(i++))
                         }));
 
         auto laddr_content = vbox({
@@ -233,15 +233,15 @@ CompatMSICap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
 
         lower.push_back(CreateCapRegInfo(std::format("[compat][{:#02x}] MSI", off),
                                          "Message Address +0x4", std::move(laddr_content),
-                                         &vis[i - 2]));
+                                         vis.Handle(i - 2)));
         lower.push_back(CreateCapRegInfo(std::format("[compat][{:#02x}] MSI", off),
                                          "Message Address Upper +0x8", std::move(uaddr_content),
-                                         &vis[i - 1]));
+                                         vis.Handle(i - 1)));
     } else {
         std::ranges::fill_n(std::back_inserter(vis), 1, 0);
         auto msg_addr_lower = *reinterpret_cast<const uint32_t *>(dev->cfg_space_.get() + off + 0x4);
         upper.push_back(Container::Horizontal({
-                            RegButtonComp("Message Address +0x4", &vis[i++])
+                            RegButtonComp("Message Address +0x4", vis.Handle(i++))
                         }));
 
         auto laddr_content = vbox({
@@ -262,7 +262,7 @@ CompatMSICap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
 
         lower.push_back(CreateCapRegInfo(std::format("[compat][{:#02x}] MSI", off),
                                          "Message Address +0x4", std::move(laddr_content),
-                                         &vis[i - 1]));
+                                         vis.Handle(i - 1)));
     }
 
     // (extended) message data
@@ -271,9 +271,9 @@ CompatMSICap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
     auto msg_data_off = msi_msg_ctrl_reg->addr_64_bit_capable ? 0xc : 0x8;
     upper.push_back(Container::Horizontal({
                         RegButtonComp(std::format("Extended Message Data +{:#x}", msg_data_off + 0x2),
-                                      &vis[i++]),
+                                      vis.Handle(i++)),
                         RegButtonComp(std::format("Message Data +{:#x}", msg_data_off),
-                                      &vis[i++])
+                                      vis.Handle(i++))
                     }));
 
     auto msg_data = *reinterpret_cast<const uint16_t *>(dev->cfg_space_.get() + off + msg_data_off);
@@ -284,11 +284,11 @@ CompatMSICap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
 
     lower.push_back(CreateCapRegInfo(std::format("[compat][{:#02x}] MSI", off),
                                      std::format("Extended Message Data +{:#x}", msg_data_off + 0x2),
-                                     std::move(ext_data_content), &vis[i - 2]));
+                                     std::move(ext_data_content), vis.Handle(i - 2)));
 
     lower.push_back(CreateCapRegInfo(std::format("[compat][{:#02x}] MSI", off),
                                      std::format("Message Data +{:#x}", msg_data_off),
-                                     std::move(data_content), &vis[i - 1]));
+                                     std::move(data_content), vis.Handle(i - 1)));
 
     // mask/pending bits info
     if (msi_msg_ctrl_reg->per_vector_mask_capable) {
@@ -302,11 +302,11 @@ CompatMSICap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
         std::ranges::fill_n(std::back_inserter(vis), 2, 0);
         upper.push_back(Container::Horizontal({
                             RegButtonComp(std::format("Mask Bits +{:#x}", mask_bits_off),
-                                          &vis[i++]),
+                                          vis.Handle(i++)),
                         }));
         upper.push_back(Container::Horizontal({
                             RegButtonComp(std::format("Pending Bits +{:#x}", pending_bits_off),
-                                          &vis[i++]),
+                                          vis.Handle(i++)),
                         }));
 
         auto mask_bits_content = hbox({
@@ -329,11 +329,11 @@ CompatMSICap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
 
         lower.push_back(CreateCapRegInfo(std::format("[compat][{:#02x}] MSI", off),
                                          std::format("Mask Bits +{:#x}", mask_bits_off),
-                                         std::move(mask_bits_content), &vis[i - 2]));
+                                         std::move(mask_bits_content), vis.Handle(i - 2)));
 
         lower.push_back(CreateCapRegInfo(std::format("[compat][{:#02x}] MSI", off),
                                          std::format("Pending Bits +{:#x}", pending_bits_off),
-                                         std::move(pending_bits_content), &vis[i - 1]));
+                                         std::move(pending_bits_content), vis.Handle(i - 1)));
     }
 
     return {std::move(upper), std::move(lower)};
@@ -341,20 +341,20 @@ CompatMSICap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
 
 static capability_comp_ctx
 CompatPCIECap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
-              std::vector<uint8_t> &vis)
+              RegVisState &vis)
 {
     Components upper, lower;
     constexpr auto reg_per_cap = 22;
     size_t i = vis.size();
     std::ranges::fill_n(std::back_inserter(vis), reg_per_cap, 0);
 
-    auto off = std::get<3>(cap);
+    auto off = cap.off();
     auto pcie_cap = reinterpret_cast<const PciECap *>(dev->cfg_space_.get() + off);
 
     // pcie capabilities
     upper.push_back(CapDelimComp(cap));
     upper.push_back(Container::Horizontal({
-                        RegButtonComp("PCI Express Capabilities +0x2", &vis[i++]),
+                        RegButtonComp("PCI Express Capabilities +0x2", vis.Handle(i++)),
                         CapHdrComp(pcie_cap->hdr)
                     }));
 
@@ -374,11 +374,11 @@ CompatPCIECap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
 
     lower.push_back(CreateCapRegInfo(std::format("[compat][{:#02x}] PCI Express", off),
                                      "PCIe Capabilities +0x2", std::move(pcie_cap_reg_content),
-                                     &vis[i - 1]));
+                                     vis.Handle(i - 1)));
 
     // device capabilities
     upper.push_back(Container::Horizontal({
-                        RegButtonComp("Device Capabilities +0x4", &vis[i++]),
+                        RegButtonComp("Device Capabilities +0x4", vis.Handle(i++)),
                     }));
 
     std::array<uint16_t, 8> pyld_sz_map { 128, 256, 512, 1024, 2048, 4096, 0, 0};
@@ -411,12 +411,12 @@ CompatPCIECap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
 
     lower.push_back(CreateCapRegInfo(std::format("[compat][{:#02x}] PCI Express", off),
                                      "Device Capabilities +0x4", std::move(dev_caps_content),
-                                     &vis[i - 1]));
+                                     vis.Handle(i - 1)));
 
     // device control / status
     upper.push_back(Container::Horizontal({
-                        RegButtonComp("Device Status +0xa", &vis[i++]),
-                        RegButtonComp("Device Control +0x8", &vis[i++]),
+                        RegButtonComp("Device Status +0xa", vis.Handle(i++)),
+                        RegButtonComp("Device Control +0x8", vis.Handle(i++)),
                     }));
 
     auto dev_ctrl_content = vbox({
@@ -455,7 +455,7 @@ CompatPCIECap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
 
     lower.push_back(CreateCapRegInfo(std::format("[compat][{:#02x}] PCI Express", off),
                                      "Device Control +0x8", std::move(dev_ctrl_content),
-                                     &vis[i - 1]));
+                                     vis.Handle(i - 1)));
 
     auto dev_status_content = vbox({
         RegFieldCompElem(0, 0, " Correctable error detected",
@@ -477,13 +477,13 @@ CompatPCIECap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
 
     lower.push_back(CreateCapRegInfo(std::format("[compat][{:#02x}] PCI Express", off),
                                      "Device Status +0xa", std::move(dev_status_content),
-                                     &vis[i - 2]));
+                                     vis.Handle(i - 2)));
 
     // link capabilities
     auto link_cap = reinterpret_cast<const uint32_t *>(&pcie_cap->link_cap);
     if (*link_cap != 0) {
         upper.push_back(Container::Horizontal({
-                            RegButtonComp("Link Capabilities +0xc", &vis[i++]),
+                            RegButtonComp("Link Capabilities +0xc", vis.Handle(i++)),
                         }));
 
         auto link_cap_content = vbox({
@@ -519,7 +519,7 @@ CompatPCIECap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
 
         lower.push_back(CreateCapRegInfo(std::format("[compat][{:#02x}] PCI Express", off),
                                          "Link Capabilities +0xc", std::move(link_cap_content),
-                                         &vis[i - 1]));
+                                         vis.Handle(i - 1)));
     } else {
         upper.push_back(Container::Horizontal({
                             EmptyCapRegComp("Link Capabilities +0xc")
@@ -530,8 +530,8 @@ CompatPCIECap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
     auto lctrl_stat_dw = reinterpret_cast<const uint32_t *>(&pcie_cap->link_ctl);
     if (*lctrl_stat_dw != 0) {
         upper.push_back(Container::Horizontal({
-                            RegButtonComp("Link Status +0x12", &vis[i++]),
-                            RegButtonComp("Link Control +0x10", &vis[i++]),
+                            RegButtonComp("Link Status +0x12", vis.Handle(i++)),
+                            RegButtonComp("Link Control +0x10", vis.Handle(i++)),
                         }));
 
         auto link_ctrl_content = vbox({
@@ -568,7 +568,7 @@ CompatPCIECap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
 
         lower.push_back(CreateCapRegInfo(std::format("[compat][{:#02x}] PCI Express", off),
                                          "Link Control +0x10", std::move(link_ctrl_content),
-                                         &vis[i - 1]));
+                                         vis.Handle(i - 1)));
 
         auto link_status_content = vbox({
             RegFieldVerbElem(0, 3, LinkSpeedDesc(LinkSpeedRepType::current,
@@ -593,7 +593,7 @@ CompatPCIECap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
 
         lower.push_back(CreateCapRegInfo(std::format("[compat][{:#02x}] PCI Express", off),
                                          "Link Status +0x12", std::move(link_status_content),
-                                         &vis[i - 2]));
+                                         vis.Handle(i - 2)));
     } else {
         upper.push_back(Container::Horizontal({
                             EmptyCapRegComp("Link Status +0x12"),
@@ -605,7 +605,7 @@ CompatPCIECap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
     auto slot_cap = reinterpret_cast<const uint32_t *>(&pcie_cap->slot_cap);
     if (*slot_cap != 0) {
         upper.push_back(Container::Horizontal({
-                            RegButtonComp("Slot Capabilities +0x14", &vis[i++]),
+                            RegButtonComp("Slot Capabilities +0x14", vis.Handle(i++)),
                         }));
         auto slot_cap_content = vbox({
             RegFieldCompElem(0, 0, " Attention button present",
@@ -637,7 +637,7 @@ CompatPCIECap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
 
         lower.push_back(CreateCapRegInfo(std::format("[compat][{:#02x}] PCI Express", off),
                                          "Slot Capabilities +0x14", std::move(slot_cap_content),
-                                         &vis[i - 1]));
+                                         vis.Handle(i - 1)));
     } else {
         upper.push_back(Container::Horizontal({
                             EmptyCapRegComp("Slot Capabilities +0x14"),
@@ -648,8 +648,8 @@ CompatPCIECap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
     auto slot_stat_ctrl_dw = reinterpret_cast<const uint32_t *>(&pcie_cap->slot_ctl);
     if (*slot_stat_ctrl_dw != 0) {
         upper.push_back(Container::Horizontal({
-                            RegButtonComp("Slot Status +0x1a", &vis[i++]),
-                            RegButtonComp("Slot Control +0x18", &vis[i++]),
+                            RegButtonComp("Slot Status +0x1a", vis.Handle(i++)),
+                            RegButtonComp("Slot Control +0x18", vis.Handle(i++)),
                         }));
 
         auto slot_stat_content = vbox({
@@ -678,7 +678,7 @@ CompatPCIECap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
 
         lower.push_back(CreateCapRegInfo(std::format("[compat][{:#02x}] PCI Express", off),
                                          "Slot Status +0x1a", std::move(slot_stat_content),
-                                         &vis[i - 2]));
+                                         vis.Handle(i - 2)));
 
         auto slot_ctrl_content = vbox({
             RegFieldCompElem(0, 0, " Attention button pressed enable",
@@ -709,7 +709,7 @@ CompatPCIECap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
 
         lower.push_back(CreateCapRegInfo(std::format("[compat][{:#02x}] PCI Express", off),
                                          "Slot Control +0x18", std::move(slot_ctrl_content),
-                                         &vis[i - 1]));
+                                         vis.Handle(i - 1)));
 
     } else {
         upper.push_back(Container::Horizontal({
@@ -722,8 +722,8 @@ CompatPCIECap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
     auto root_caps_ctrl_dw = reinterpret_cast<const uint32_t *>(&pcie_cap->root_ctl);
     if (*root_caps_ctrl_dw != 0) {
         upper.push_back(Container::Horizontal({
-                            RegButtonComp("Root Capabilities +0x1e", &vis[i++]),
-                            RegButtonComp("Root Control +0x1c", &vis[i++]),
+                            RegButtonComp("Root Capabilities +0x1e", vis.Handle(i++)),
+                            RegButtonComp("Root Control +0x1c", vis.Handle(i++)),
                         }));
 
         auto root_cap_content = vbox({
@@ -733,7 +733,7 @@ CompatPCIECap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
 
         lower.push_back(CreateCapRegInfo(std::format("[compat][{:#02x}] PCI Express", off),
                                          "Root Capabilities +0x1e", std::move(root_cap_content),
-                                         &vis[i - 2]));
+                                         vis.Handle(i - 2)));
 
         auto root_ctrl_content = vbox({
             RegFieldCompElem(0, 0, " Sys error on correctable err enable",
@@ -751,7 +751,7 @@ CompatPCIECap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
 
         lower.push_back(CreateCapRegInfo(std::format("[compat][{:#02x}] PCI Express", off),
                                          "Root Control +0x1c", std::move(root_ctrl_content),
-                                         &vis[i - 1]));
+                                         vis.Handle(i - 1)));
     } else {
         upper.push_back(Container::Horizontal({
                             EmptyCapRegComp("Root Capabilities +0x1e"),
@@ -763,7 +763,7 @@ CompatPCIECap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
     auto root_status = reinterpret_cast<const uint32_t *>(&pcie_cap->root_status);
     if (*root_status != 0) {
         upper.push_back(Container::Horizontal({
-                            RegButtonComp("Root Status +0x20", &vis[i++]),
+                            RegButtonComp("Root Status +0x20", vis.Handle(i++)),
                         }));
 
         auto root_status_content = vbox({
@@ -777,7 +777,7 @@ CompatPCIECap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
 
         lower.push_back(CreateCapRegInfo(std::format("[compat][{:#02x}] PCI Express", off),
                                          "Root Status +0x20", std::move(root_status_content),
-                                         &vis[i - 1]));
+                                         vis.Handle(i - 1)));
     } else {
         upper.push_back(Container::Horizontal({
                             EmptyCapRegComp("Root Status +0x20"),
@@ -788,7 +788,7 @@ CompatPCIECap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
     auto dev_cap_2 = reinterpret_cast<const uint32_t *>(&pcie_cap->dev_cap2);
     if (*dev_cap_2 != 0) {
         upper.push_back(Container::Horizontal({
-                            RegButtonComp("Device Capabilities 2 +0x24", &vis[i++]),
+                            RegButtonComp("Device Capabilities 2 +0x24", vis.Handle(i++)),
                         }));
 
         auto dev_cap2_content = vbox({
@@ -841,7 +841,7 @@ CompatPCIECap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
 
         lower.push_back(CreateCapRegInfo(std::format("[compat][{:#02x}] PCI Express", off),
                                          "Device Capabilities 2 +0x24", std::move(dev_cap2_content),
-                                         &vis[i - 1]));
+                                         vis.Handle(i - 1)));
     } else {
         upper.push_back(Container::Horizontal({
                             EmptyCapRegComp("Device Capabilities 2 +0x24"),
@@ -853,7 +853,7 @@ CompatPCIECap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
     if (*dev_ctrl2_stat2_dw != 0) {
         upper.push_back(Container::Horizontal({
                             EmptyCapRegComp("Device Status 2 +0x2a"),
-                            RegButtonComp("Device Control 2 +0x28", &vis[i++]),
+                            RegButtonComp("Device Control 2 +0x28", vis.Handle(i++)),
                         }));
 
         auto dev_ctrl2_content = vbox({
@@ -886,7 +886,7 @@ CompatPCIECap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
 
         lower.push_back(CreateCapRegInfo(std::format("[compat][{:#02x}] PCI Express", off),
                                          "Device Control 2 +0x28", std::move(dev_ctrl2_content),
-                                         &vis[i - 1]));
+                                         vis.Handle(i - 1)));
     } else {
         upper.push_back(Container::Horizontal({
                             EmptyCapRegComp("Device Status 2 +0x2a"),
@@ -898,7 +898,7 @@ CompatPCIECap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
     auto link_cap2_dw = reinterpret_cast<const uint32_t *>(&pcie_cap->link_cap2);
     if (*link_cap2_dw != 0) {
         upper.push_back(Container::Horizontal({
-                            RegButtonComp("Link Capabilities 2 +0x2c", &vis[i++]),
+                            RegButtonComp("Link Capabilities 2 +0x2c", vis.Handle(i++)),
                         }));
 
         auto link_cap2_content = vbox({
@@ -924,7 +924,7 @@ CompatPCIECap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
 
         lower.push_back(CreateCapRegInfo(std::format("[compat][{:#02x}] PCI Express", off),
                                          "Link Capabilities 2 +0x2c", std::move(link_cap2_content),
-                                         &vis[i - 1]));
+                                         vis.Handle(i - 1)));
     } else {
         upper.push_back(Container::Horizontal({
                             EmptyCapRegComp("Link Capabilities 2 +0x2c"),
@@ -935,8 +935,8 @@ CompatPCIECap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
     auto link_stat2_ctrl2_dw = reinterpret_cast<const uint32_t *>(&pcie_cap->link_ctl2);
     if (*link_stat2_ctrl2_dw != 0) {
         upper.push_back(Container::Horizontal({
-                            RegButtonComp("Link Status 2 +0x32", &vis[i++]),
-                            RegButtonComp("Link Control 2 +0x30", &vis[i++]),
+                            RegButtonComp("Link Status 2 +0x32", vis.Handle(i++)),
+                            RegButtonComp("Link Control 2 +0x30", vis.Handle(i++)),
                         }));
 
         auto link_stat2_content = vbox({
@@ -968,7 +968,7 @@ CompatPCIECap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
 
         lower.push_back(CreateCapRegInfo(std::format("[compat][{:#02x}] PCI Express", off),
                                          "Link Status 2 +0x32", std::move(link_stat2_content),
-                                         &vis[i - 2]));
+                                         vis.Handle(i - 2)));
 
         auto link_ctrl2_content = vbox({
             RegFieldCompElem(0, 3, LinkSpeedDesc(LinkSpeedRepType::target,
@@ -993,7 +993,7 @@ CompatPCIECap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
 
         lower.push_back(CreateCapRegInfo(std::format("[compat][{:#02x}] PCI Express", off),
                                          "Link Control 2 +0x30", std::move(link_ctrl2_content),
-                                         &vis[i - 1]));
+                                         vis.Handle(i - 1)));
     } else {
         upper.push_back(Container::Horizontal({
                             EmptyCapRegComp("Link Status 2 +0x32"),
@@ -1017,19 +1017,19 @@ CompatPCIECap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
 
 static capability_comp_ctx
 CompatMSIxCap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
-              std::vector<uint8_t> &vis)
+              RegVisState &vis)
 {
     Components upper, lower;
     constexpr auto reg_per_cap = 3;
     size_t i = vis.size();
     std::ranges::fill_n(std::back_inserter(vis), reg_per_cap, 0);
 
-    auto off = std::get<3>(cap);
+    auto off = cap.off();
     auto msix_cap = reinterpret_cast<const PciMSIxCap *>(dev->cfg_space_.get() + off);
 
     upper.push_back(CapDelimComp(cap));
     upper.push_back(Container::Horizontal({
-                        RegButtonComp("Message Control +0x2", &vis[i++]),
+                        RegButtonComp("Message Control +0x2", vis.Handle(i++)),
                         CapHdrComp(msix_cap->hdr)
                     }));
 
@@ -1041,10 +1041,10 @@ CompatMSIxCap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
         RegFieldCompElem(15, 15, " MSI-X enable", msix_cap->msg_ctrl.msix_ena)
     });
     lower.push_back(CreateCapRegInfo(std::format("[compat][{:#02x}] MSI-X", off),
-                                     "Message Control +0x2", std::move(msix_mc_content), &vis[i - 1]));
+                                     "Message Control +0x2", std::move(msix_mc_content), vis.Handle(i - 1)));
 
     upper.push_back(Container::Horizontal({
-                        RegButtonComp("Table Off/BIR +0x4", &vis[i++]),
+                        RegButtonComp("Table Off/BIR +0x4", vis.Handle(i++)),
                     }));
 
     auto msix_tbl_off_bir_content = vbox({
@@ -1054,10 +1054,10 @@ CompatMSIxCap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
 
     lower.push_back(CreateCapRegInfo(std::format("[compat][{:#02x}] MSI-X", off),
                                      "Message Table Off/BIR +0x4",
-                                     std::move(msix_tbl_off_bir_content), &vis[i - 1]));
+                                     std::move(msix_tbl_off_bir_content), vis.Handle(i - 1)));
 
     upper.push_back(Container::Horizontal({
-                        RegButtonComp("PBA Off/BIR +0x8", &vis[i++]),
+                        RegButtonComp("PBA Off/BIR +0x8", vis.Handle(i++)),
                     }));
 
     auto msix_pba_off_bir_content = vbox({
@@ -1067,14 +1067,14 @@ CompatMSIxCap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
 
     lower.push_back(CreateCapRegInfo(std::format("[compat][{:#02x}] MSI-X", off),
                                      "PBA Off/BIR +0x8",
-                                     std::move(msix_pba_off_bir_content), &vis[i - 1]));
+                                     std::move(msix_pba_off_bir_content), vis.Handle(i - 1)));
 
     return {std::move(upper), std::move(lower)};
 }
 
 capability_comp_ctx
 GetCompatCapComponents(const pci::PciDevBase *dev, const CompatCapID cap_id,
-                       const pci::CapDesc &cap, std::vector<uint8_t> &vis)
+                       const pci::CapDesc &cap, RegVisState &vis)
 {
     switch(cap_id) {
     case CompatCapID::null_cap:
@@ -17,7 +17,7 @@ namespace ui {
 
 static capability_comp_ctx
 ExtSecondaryPCIECap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
-                    std::vector<uint8_t> &vis)
+                    RegVisState &vis)
 {
     Components upper, lower;
 
@@ -38,11 +38,11 @@ ExtSecondaryPCIECap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
     size_t i = vis.size();
     std::ranges::fill_n(std::back_inserter(vis), reg_per_cap, 0);
 
-    auto off = std::get<3>(cap);
+    auto off = cap.off();
     auto sec_pcie_cap = reinterpret_cast<const SecPciECap *>(dev->cfg_space_.get() + off);
     upper.push_back(CapDelimComp(cap));
     upper.push_back(Container::Horizontal({
-                        RegButtonComp("Link Control 3 +0x4", &vis[i++]),
+                        RegButtonComp("Link Control 3 +0x4", vis.Handle(i++)),
                         CapHdrComp(sec_pcie_cap->hdr)
                     }));
 
@@ -57,10 +57,10 @@ ExtSecondaryPCIECap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
     });
     lower.push_back(CreateCapRegInfo(std::format("[extended][{:#02x}] Secondary PCIe", off),
                                      "Link Control 3 +0x4",
-                                     std::move(link_ctl3_content), &vis[i - 1]));
+                                     std::move(link_ctl3_content), vis.Handle(i - 1)));
 
     upper.push_back(Container::Horizontal({
-                        RegButtonComp("Lane Error Status +0x8", &vis[i++]),
+                        RegButtonComp("Lane Error Status +0x8", vis.Handle(i++)),
                     }));
 
     auto lane_err_status_content = vbox({
@@ -70,14 +70,14 @@ ExtSecondaryPCIECap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
     });
     lower.push_back(CreateCapRegInfo(std::format("[extended][{:#02x}] Secondary PCIe", off),
                                      "Lane Error Status +0x8",
-                                     std::move(lane_err_status_content), &vis[i - 1]));
+                                     std::move(lane_err_status_content), vis.Handle(i - 1)));
 
     // Check of port supports 8.0GT/s link speed or higher
     if (pcie_cap->link_cap2.supported_speed_vec & 0x4) {
         upper.push_back(
                 Container::Horizontal({
                     RegButtonComp(std::format("Lane Equalization Control [{} lane(s)] +0xc",
-                                  max_link_width), &vis[i++]),
+                                  max_link_width), vis.Handle(i++)),
         }));
 
         for (uint32_t cur_link = 0; cur_link < max_link_width; cur_link++) {
@@ -111,7 +111,7 @@ ExtSecondaryPCIECap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
                     CreateCapRegInfo(std::format("[extended][{:#02x}] Secondary PCIe", off),
                                      std::format("Lane #{} Equalization Control +{:#01x}",
                                                  cur_link, (0xc + cur_link * 0x2)),
-                                     std::move(lane_eq_ctl_content), &vis[i - 1]));
+                                     std::move(lane_eq_ctl_content), vis.Handle(i - 1)));
         }
     }
 
@@ -120,20 +120,20 @@ ExtSecondaryPCIECap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
 
 static capability_comp_ctx
 ExtDataLinkFeatureCap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
-                      std::vector<uint8_t> &vis)
+                      RegVisState &vis)
 {
     Components upper, lower;
     constexpr auto reg_per_cap = 2;
     size_t i = vis.size();
     std::ranges::fill_n(std::back_inserter(vis), reg_per_cap, 0);
 
-    auto off = std::get<3>(cap);
+    auto off = cap.off();
     auto dlink_feature_cap = reinterpret_cast<const DataLinkFeatureCap *>
                                              (dev->cfg_space_.get() + off);
 
     upper.push_back(CapDelimComp(cap));
     upper.push_back(Container::Horizontal({
-                        RegButtonComp("Data Link Feature Capabilities +0x4", &vis[i++]),
+                        RegButtonComp("Data Link Feature Capabilities +0x4", vis.Handle(i++)),
                         CapHdrComp(dlink_feature_cap->hdr)
                     }));
 
@@ -152,10 +152,10 @@ ExtDataLinkFeatureCap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
             CreateCapRegInfo(std::format(
                                 "[extended][{:#02x}] Data Link Feature", off),
                              "Data Link Feature Capabilities +0x4",
-                             std::move(dlink_feature_caps_content), &vis[i - 1]));
+                             std::move(dlink_feature_caps_content), vis.Handle(i - 1)));
 
     upper.push_back(Container::Horizontal({
-                        RegButtonComp("Data Link Feature Status +0x8", &vis[i++]),
+                        RegButtonComp("Data Link Feature Status +0x8", vis.Handle(i++)),
                     }));
 
     std::bitset<23> rem_dlink_feat_map {dlink_feature_cap->dlink_feat_stat.rem_data_link_feat_supp};
@@ -173,26 +173,26 @@ ExtDataLinkFeatureCap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
             CreateCapRegInfo(std::format(
                                 "[extended][{:#02x}] Data Link Feature", off),
                              "Data Link Feature Status +0x8",
-                             std::move(dlink_feature_stat_content), &vis[i - 1]));
+                             std::move(dlink_feature_stat_content), vis.Handle(i - 1)));
 
     return {std::move(upper), std::move(lower)};
 }
 
 static capability_comp_ctx
 ExtARICap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
-                      std::vector<uint8_t> &vis)
+                      RegVisState &vis)
 {
     Components upper, lower;
     constexpr auto reg_per_cap = 2;
     size_t i = vis.size();
     std::ranges::fill_n(std::back_inserter(vis), reg_per_cap, 0);
 
-    auto off = std::get<3>(cap);
+    auto off = cap.off();
     auto ari_cap = reinterpret_cast<const ARICap *>(dev->cfg_space_.get() + off);
 
     upper.push_back(CapDelimComp(cap));
     upper.push_back(Container::Horizontal({
-                        RegButtonComp("ARI Capabilities +0x4", &vis[i++]),
+                        RegButtonComp("ARI Capabilities +0x4", vis.Handle(i++)),
                         CapHdrComp(ari_cap->hdr)
                     }));
 
@@ -206,10 +206,10 @@ ExtARICap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
     lower.push_back(
             CreateCapRegInfo(std::format("[extended][{:#02x}] ARI", off),
                              "ARI Capabilities +0x4",
-                             std::move(ari_cap_content), &vis[i - 1]));
+                             std::move(ari_cap_content), vis.Handle(i - 1)));
 
     upper.push_back(Container::Horizontal({
-                        RegButtonComp("ARI Control +0x6", &vis[i++]),
+                        RegButtonComp("ARI Control +0x6", vis.Handle(i++)),
                     }));
     auto ari_ctl_content = vbox({
         RegFieldCompElem(0, 0, " MFVC function groups enable", ari_cap->ari_ctl.mfvc_func_grps_ena == 1),
@@ -222,26 +222,26 @@ ExtARICap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
     lower.push_back(
             CreateCapRegInfo(std::format("[extended][{:#02x}] ARI", off),
                              "ARI Control +0x6",
-                             std::move(ari_ctl_content), &vis[i - 1]));
+                             std::move(ari_ctl_content), vis.Handle(i - 1)));
 
     return {std::move(upper), std::move(lower)};
 }
 
 static capability_comp_ctx
 ExtPASIDCap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
-            std::vector<uint8_t> &vis)
+            RegVisState &vis)
 {
     Components upper, lower;
     constexpr auto reg_per_cap = 2;
     size_t i = vis.size();
     std::ranges::fill_n(std::back_inserter(vis), reg_per_cap, 0);
 
-    auto off = std::get<3>(cap);
+    auto off = cap.off();
     auto pasid_cap = reinterpret_cast<const PASIDCap *>(dev->cfg_space_.get() + off);
 
     upper.push_back(CapDelimComp(cap));
     upper.push_back(Container::Horizontal({
-                        RegButtonComp("PASID Capability +0x4", &vis[i++]),
+                        RegButtonComp("PASID Capability +0x4", vis.Handle(i++)),
                         CapHdrComp(pasid_cap->hdr)
                     }));
 
@@ -257,10 +257,10 @@ ExtPASIDCap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
     lower.push_back(
             CreateCapRegInfo(std::format("[extended][{:#02x}] PASID", off),
                              "PASID Capability +0x4",
-                             std::move(pasid_cap_content), &vis[i - 1]));
+                             std::move(pasid_cap_content), vis.Handle(i - 1)));
 
     upper.push_back(Container::Horizontal({
-                        RegButtonComp("PASID Control +0x6", &vis[i++]),
+                        RegButtonComp("PASID Control +0x6", vis.Handle(i++)),
                     }));
     auto pasid_ctl_content = vbox({
         RegFieldCompElem(0, 0, " PASID enable", pasid_cap->pasid_ctl.pasid_ena),
@@ -271,14 +271,14 @@ ExtPASIDCap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
     lower.push_back(
             CreateCapRegInfo(std::format("[extended][{:#02x}] PASID", off),
                              "PASID Control +0x6",
-                             std::move(pasid_ctl_content), &vis[i - 1]));
+                             std::move(pasid_ctl_content), vis.Handle(i - 1)));
 
     return {std::move(upper), std::move(lower)};
 }
 
 static capability_comp_ctx
 ExtAERCap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
-          std::vector<uint8_t> &vis)
+          RegVisState &vis)
 {
     Components upper, lower;
 
@@ -294,12 +294,12 @@ ExtAERCap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
     size_t i = vis.size();
     std::ranges::fill_n(std::back_inserter(vis), reg_per_cap, 0);
 
-    auto off = std::get<3>(cap);
+    auto off = cap.off();
     auto aer_cap = reinterpret_cast<const AERCap *>(dev->cfg_space_.get() + off);
     auto reg_info_cap_hdr = std::format("[extended][{:#02x}] AER", off);
     upper.push_back(CapDelimComp(cap));
     upper.push_back(Container::Horizontal({
-                        RegButtonComp("Uncorrectable Error Status +0x4", &vis[i++]),
+                        RegButtonComp("Uncorrectable Error Status +0x4", vis.Handle(i++)),
                         CapHdrComp(aer_cap->hdr)
                     }));
 
@@ -327,10 +327,10 @@ ExtAERCap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
     });
     lower.push_back(CreateCapRegInfo(reg_info_cap_hdr,
                                      "Uncorrectable Error Status +0x4",
-                                     std::move(uncorr_err_status_content), &vis[i - 1]));
+                                     std::move(uncorr_err_status_content), vis.Handle(i - 1)));
 
     upper.push_back(Container::Horizontal({
-                        RegButtonComp("Uncorrectable Error Mask +0x8", &vis[i++]),
+                        RegButtonComp("Uncorrectable Error Mask +0x8", vis.Handle(i++)),
                     }));
 
     auto uncorr_err_mask_content = vbox({
@@ -357,10 +357,10 @@ ExtAERCap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
     });
     lower.push_back(CreateCapRegInfo(reg_info_cap_hdr,
                                      "Uncorrectable Error Mask +0x8",
-                                     std::move(uncorr_err_mask_content), &vis[i - 1]));
+                                     std::move(uncorr_err_mask_content), vis.Handle(i - 1)));
 
     upper.push_back(Container::Horizontal({
-                        RegButtonComp("Uncorrectable Error Severity +0xc", &vis[i++]),
+                        RegButtonComp("Uncorrectable Error Severity +0xc", vis.Handle(i++)),
                     }));
 
     auto uncorr_err_sev_content = vbox({
@@ -387,10 +387,10 @@ ExtAERCap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
     });
     lower.push_back(CreateCapRegInfo(reg_info_cap_hdr,
                                      "Uncorrectable Error Severity +0xc",
-                                     std::move(uncorr_err_sev_content), &vis[i - 1]));
+                                     std::move(uncorr_err_sev_content), vis.Handle(i - 1)));
 
     upper.push_back(Container::Horizontal({
-                        RegButtonComp("Correctable Error Status +0x10", &vis[i++]),
+                        RegButtonComp("Correctable Error Status +0x10", vis.Handle(i++)),
                     }));
 
     auto corr_err_status_content = vbox({
@@ -408,10 +408,10 @@ ExtAERCap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
     });
     lower.push_back(CreateCapRegInfo(reg_info_cap_hdr,
                                      "Correctable Error Status +0x10",
-                                     std::move(corr_err_status_content), &vis[i - 1]));
+                                     std::move(corr_err_status_content), vis.Handle(i - 1)));
 
     upper.push_back(Container::Horizontal({
-                        RegButtonComp("Correctable Error Mask +0x14", &vis[i++]),
+                        RegButtonComp("Correctable Error Mask +0x14", vis.Handle(i++)),
                     }));
 
     auto corr_err_mask_content = vbox({
@@ -429,10 +429,10 @@ ExtAERCap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
     });
     lower.push_back(CreateCapRegInfo(reg_info_cap_hdr,
                                      "Correctable Error Mask +0x14",
-                                     std::move(corr_err_mask_content), &vis[i - 1]));
+                                     std::move(corr_err_mask_content), vis.Handle(i - 1)));
 
     upper.push_back(Container::Horizontal({
-                        RegButtonComp("Advanced Error Capabilities and Control +0x18", &vis[i++]),
+                        RegButtonComp("Advanced Error Capabilities and Control +0x18", vis.Handle(i++)),
                     }));
 
     auto adv_err_cap_ctl_content = vbox({
@@ -451,10 +451,10 @@ ExtAERCap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
     });
     lower.push_back(CreateCapRegInfo(reg_info_cap_hdr,
                                      "Advanced Error Capabilities and Control +0x18",
-                                     std::move(adv_err_cap_ctl_content), &vis[i - 1]));
+                                     std::move(adv_err_cap_ctl_content), vis.Handle(i - 1)));
 
     upper.push_back(Container::Horizontal({
-                        RegButtonComp("Header Log +0x1c", &vis[i++]),
+                        RegButtonComp("Header Log +0x1c", vis.Handle(i++)),
                     }));
 
     // 7.8.4.8 header log register, need to do byteswap before building the component
@@ -466,7 +466,7 @@ ExtAERCap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
     auto hdr_log_content = GetHexDumpElem("TLP hdr >>>", hdr_log.data(), hdr_log.size(), 4);
     lower.push_back(CreateCapRegInfo(reg_info_cap_hdr,
                                      "Header Log +0x1c",
-                                     std::move(hdr_log_content), &vis[i - 1]));
+                                     std::move(hdr_log_content), vis.Handle(i - 1)));
 
     auto pcie_cap = reinterpret_cast<const PciECap *>(dev->cfg_space_.get() + pcie_cap_off);
     // The following 4 registers are only available for root ports and root complex event collectors
@@ -476,7 +476,7 @@ ExtAERCap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
 
     if (dev_is_rp_or_rcec) {
         upper.push_back(Container::Horizontal({
-                            RegButtonComp("Root Error Command +0x2c", &vis[i++]),
+                            RegButtonComp("Root Error Command +0x2c", vis.Handle(i++)),
                         }));
 
         auto root_err_comm_content = vbox({
@@ -488,10 +488,10 @@ ExtAERCap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
 
         lower.push_back(CreateCapRegInfo(reg_info_cap_hdr,
                                          "Root Error Command +0x2c",
-                                         std::move(root_err_comm_content), &vis[i - 1]));
+                                         std::move(root_err_comm_content), vis.Handle(i - 1)));
 
         upper.push_back(Container::Horizontal({
-                            RegButtonComp("Root Error Status +0x30", &vis[i++]),
+                            RegButtonComp("Root Error Status +0x30", vis.Handle(i++)),
                         }));
 
         auto root_err_status_content = vbox({
@@ -509,10 +509,10 @@ ExtAERCap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
 
         lower.push_back(CreateCapRegInfo(reg_info_cap_hdr,
                                          "Root Error Status +0x30",
-                                         std::move(root_err_status_content), &vis[i - 1]));
+                                         std::move(root_err_status_content), vis.Handle(i - 1)));
 
         upper.push_back(Container::Horizontal({
-                            RegButtonComp("Error Source ID +0x34", &vis[i++]),
+                            RegButtonComp("Error Source ID +0x34", vis.Handle(i++)),
                         }));
 
         auto err_srcid_content = vbox({
@@ -524,7 +524,7 @@ ExtAERCap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
 
         lower.push_back(CreateCapRegInfo(reg_info_cap_hdr,
                                          "Error Source ID +0x34",
-                                         std::move(err_srcid_content), &vis[i - 1]));
+                                         std::move(err_srcid_content), vis.Handle(i - 1)));
     } else {
         upper.push_back(Container::Horizontal({
                             EmptyCapRegComp("Root Error Command +0x2c")
@@ -540,7 +540,7 @@ ExtAERCap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
 
     if (aer_cap->adv_err_cap_ctl.tlp_pref_log_present) {
         upper.push_back(Container::Horizontal({
-                            RegButtonComp("TLP Prefix Log +0x38", &vis[i++]),
+                            RegButtonComp("TLP Prefix Log +0x38", vis.Handle(i++)),
                         }));
 
         // 7.8.4.12 tlp prefix log register, need to do byteswap before building the component
@@ -553,7 +553,7 @@ ExtAERCap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
                                                    tlp_pref_log.data(), tlp_pref_log.size(), 4);
         lower.push_back(CreateCapRegInfo(reg_info_cap_hdr,
                                          "TLP Prefix Log +0x38",
-                                         std::move(tlp_pref_log_content), &vis[i - 1]));
+                                         std::move(tlp_pref_log_content), vis.Handle(i - 1)));
     } else {
         upper.push_back(Container::Horizontal({
                             EmptyCapRegComp("TLP Prefix Log +0x38")
@@ -565,7 +565,7 @@ ExtAERCap(const pci::PciDevBase *dev, const pci::CapDesc &cap,
 
 capability_comp_ctx
 GetExtendedCapComponents(const pci::PciDevBase *dev, const ExtCapID cap_id,
-                         const pci::CapDesc &cap, std::vector<uint8_t> &vis)
+                         const pci::CapDesc &cap, RegVisState &vis)
 {
     switch(cap_id) {
     case ExtCapID::null_cap:
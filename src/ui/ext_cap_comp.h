@@ -12,6 +12,6 @@ namespace ui {
 // Each capability might be composed of multiple registers.
 capability_comp_ctx
 GetExtendedCapComponents(const pci::PciDevBase *dev, const ExtCapID cap_id,
-                         const pci::CapDesc &cap, std::vector<uint8_t> &vis);
+                         const pci::CapDesc &cap, RegVisState &vis);
 
 } // namespace ui
@@ -0,0 +1,116 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2025 Petr Vyazovik <xen@f-m.fm>
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+namespace ui {
+
+class RegVisState;
+
+// Stable reference to a single register visibility flag.
+// Unlike a raw pointer into the flags storage it survives storage growth.
+class RegVisHandle
+{
+public:
+    RegVisHandle() = default;
+    RegVisHandle(RegVisState *store, uint32_t idx) : store_(store), idx_(idx) {}
+
+    bool Valid() const noexcept { return store_ != nullptr; }
+    inline bool Get() const noexcept;
+    inline void Toggle() const noexcept;
+
+private:
+    RegVisState *store_ {nullptr};
+    uint32_t     idx_ {0};
+};
+
+// Visibility (highlighting) flags of all the registers of a device.
+// Flags are packed into 64-bit words, number of set flags is maintained
+// on every change, so checking if anything is highlighted is O(1).
+//
+// Flags are allocated one by one during the components creation via push_back(),
+// so the store can be filled with std::back_inserter the same way as a vector.
+// NOTE: handles refer to the store itself, so it must not be moved while
+// the components referring to it are alive.
+class RegVisState
+{
+public:
+    using value_type = uint8_t;
+
+    RegVisState() = default;
+    RegVisState(const RegVisState &) = delete;
+    RegVisState &operator=(const RegVisState &) = delete;
+
+    size_t size() const noexcept { return size_; }
+
+    void push_back(uint8_t vis)
+    {
+        if (size_ % 64 == 0)
+            bits_.push_back(0);
+        size_++;
+        Set(size_ - 1, vis != 0);
+    }
+
+    RegVisHandle Handle(size_t idx) noexcept { return {this, static_cast<uint32_t>(idx)}; }
+
+    bool Get(size_t idx) const noexcept
+    {
+        return (bits_[idx / 64] >> (idx % 64)) & 1;
+    }
+
+    void Set(size_t idx, bool vis) noexcept
+    {
+        auto &word = bits_[idx / 64];
+        const uint64_t mask = 1ULL << (idx % 64);
+        if (static_cast<bool>(word & mask) == vis)
+            return;
+
+        word ^= mask;
+        highlighted_cnt_ += vis ? 1 : -1;
+    }
+
+    bool AnyHighlighted() const noexcept { return highlighted_cnt_ != 0; }
+
+    void Reset() noexcept
+    {
+        std::fill(bits_.begin(), bits_.end(), 0);
+        highlighted_cnt_ = 0;
+    }
+
+    // Packed flags, e.g. to be kept when the components are dropped
+    const std::vector<uint64_t> &Bits() const noexcept { return bits_; }
+
+    // Restore flags saved by Bits(), ignored if the layout doesn't match
+    void Restore(const std::vector<uint64_t> &bits) noexcept
+    {
+        if (bits.size() != bits_.size())
+            return;
+
+        bits_ = bits;
+        highlighted_cnt_ = 0;
+        for (auto word : bits_)
+            highlighted_cnt_ += std::popcount(word);
+    }
+
+private:
+    std::vector<uint64_t> bits_;
+    size_t                size_ {0};
+    size_t                highlighted_cnt_ {0};
+};
+
+bool RegVisHandle::Get() const noexcept
+{
+    return store_->Get(idx_);
+}
+
+void RegVisHandle::Toggle() const noexcept
+{
+    store_->Set(idx_, !store_->Get(idx_));
+}
+
+} // namespace ui
@@ -10,7 +10,7 @@
 #include "pciex_version.h"
 
 #include <algorithm>
-#include <numeric>
+#include <climits>
 #include <format>
 #include <ranges>
 
@@ -70,7 +70,7 @@ void CanvasVisibleArea::shift(UiElemShiftDir dir, Box &box)
 
 
 // draw a simple box
-void ScrollableCanvas::DrawBoxLine(ShapeDesc desc, const Color &color)
+void CanvasTile::DrawBoxLine(ShapeDesc desc, const Color &color)
 {
     auto [x, y, len, height] = desc;
     DrawPointLine(      x,          y,       x, y + height, color);
@@ -79,8 +79,8 @@ void ScrollableCanvas::DrawBoxLine(ShapeDesc desc, const Color &color)
     DrawPointLine(x + len,          y,       x,          y, color);
 }
 
-void ScrollableCanvas::DrawBoxLine(ShapeDesc desc,
-                                   const Canvas::Stylizer &style)
+void CanvasTile::DrawBoxLine(ShapeDesc desc,
+                             const Canvas::Stylizer &style)
 {
     auto [x, y, len, height] = desc;
     DrawPointLine(      x,          y,       x, y + height, style);
@@ -93,9 +93,9 @@ void ScrollableCanvas::DrawBoxLine(ShapeDesc desc,
 // FIXME: text is expected to be single line for now
 // @pos {x, y}: x is expected to be mulitple of 2,
 //              y is expected to be multiple of 4
-void ScrollableCanvas::DrawTextBox(std::pair<uint16_t, uint16_t> pos, std::string text,
-                                   const Canvas::Stylizer &box_style,
-                                   const Canvas::Stylizer &text_style)
+void CanvasTile::DrawTextBox(PointDesc pos, std::string text,
+                             const Canvas::Stylizer &box_style,
+                             const Canvas::Stylizer &text_style)
 {
     auto [x, y] = pos;
     // symbol width is two pixels + 1 pixel on both sides
@@ -107,152 +107,341 @@ void ScrollableCanvas::DrawTextBox(std::pair<uint16_t, uint16_t> pos, std::strin
     DrawText(x + tbox_txt_xoff, y + tbox_txt_yoff , text, text_style);
 }
 
-void CanvasElemConnector::AddLine(std::pair<PointDesc, PointDesc> line_desc)
+void ScrollableCanvas::SetElements(const CanvasElems &elems, const TopoLayout &layout)
 {
-    lines_.push_back(line_desc);
+    elems_ = &elems;
+    layout_ = &layout;
+    tiles_lru_.clear();
+    tiles_.clear();
+    frame_.valid_ = false;
+
+    // canvas follows the content extent
+    auto [canvas_width, canvas_height] = GetCanvasSize(layout);
+    Resize(canvas_width, canvas_height);
+
+    const int tile_h = canvas_tile_rows * sym_height;
+    tile_rows_.assign((height_ + tile_h - 1) / tile_h, {});
+
+    for (uint32_t i = 0; i < elems.size(); i++) {
+        auto [x, y, len, height] = elems[i]->GetBounds(layout);
+        const int first_row = y / tile_h;
+        const int last_row = std::min<int>((y + height) / tile_h, tile_rows_.size() - 1);
+
+        for (int row = first_row; row <= last_row; row++)
+            tile_rows_[row].push_back(i);
+    }
 }
 
-void CanvasElemConnector::Draw(ScrollableCanvas &canvas)
+// Tiles always have the full size, so the ones already rasterised stay valid
+// after resize. Elements beyond the old extent are picked up by the next
+// SetElements() call.
+void ScrollableCanvas::Resize(const int width, const int height)
 {
-    for (const auto &line_desc : lines_) {
-        auto [p1, p2] = line_desc;
-        auto [x1, y1] = p1;
-        auto [x2, y2] = p2;
-        canvas.DrawPointLine(x1, y1, x2, y2);
-    }
+    width_ = width;
+    height_ = height;
+
+    const int tile_h = canvas_tile_rows * sym_height;
+    tile_rows_.resize((height_ + tile_h - 1) / tile_h);
+
+    VisibleAreaSetMax(width_ / sym_width, height_ / sym_height);
+    area_.off_x_ = std::min(area_.off_x_, area_.x_max_);
+    area_.off_y_ = std::min(area_.off_y_, area_.y_max_);
+
+    frame_.valid_ = false;
 }
 
-CanvasElemPCIDev::CanvasElemPCIDev(std::shared_ptr<pci::PciDevBase> dev, ElemReprMode repr_mode,
-                                   uint16_t x, uint16_t y)
-    : dev_(dev), selected_(false), has_highlighted_regs_(false)
+void ScrollableCanvas::Damage(ShapeDesc rect)
 {
-    size_t max_hlen, max_vlen;
+    auto [x, y, len, height] = rect;
+    for (int row = y / sym_height; row <= (y + height) / sym_height; row++)
+        damaged_rows_.push_back(row);
+}
 
-    // initialize text array
-    auto bdf_id_str = std::format("{} | [{:04x}:{:04x}]", dev->dev_id_str_,
-                                  dev->get_vendor_id(), dev->get_device_id());
-    max_hlen = bdf_id_str.length();
-    text_data_.push_back(std::move(bdf_id_str));
-
-    if (repr_mode == ElemReprMode::Verbose) {
-        if (!dev->ids_names_[pci::VENDOR].empty()) {
-            auto vendor_name = std::format("{}", dev->ids_names_[pci::VENDOR]);
-            if (vendor_name.length() > max_hlen)
-                max_hlen = vendor_name.length();
-            text_data_.push_back(std::move(vendor_name));
+void ScrollableCanvas::RedrawOutline(CanvasElemBox &elem)
+{
+    auto [x, y, len, height] = elem.GetBounds(*layout_);
+    const std::array<ShapeDesc, 4> edges {
+        ShapeDesc{ x, y, len, 0 }, ShapeDesc{ x, y + height, len, 0 },
+        ShapeDesc{ x, y, 0, height }, ShapeDesc{ x + len, y, 0, height }
+    };
+
+    for (auto &[key, tile] : tiles_lru_)
+        if (std::ranges::any_of(edges, [&](auto edge) { return tile.Intersects(edge); }))
+            elem.DrawOutline(tile, *layout_);
+
+    Damage({ x, y, len, height });
+}
+
+const CanvasTile &ScrollableCanvas::GetTile(const int tile_x, const int tile_y) const
+{
+    const auto key = static_cast<uint64_t>(tile_y) << 32 | static_cast<uint32_t>(tile_x);
+
+    if (auto it = tiles_.find(key); it != tiles_.end()) {
+        // move to the front of LRU
+        tiles_lru_.splice(tiles_lru_.begin(), tiles_lru_, it->second);
+        return it->second->second;
+    }
+
+    if (tiles_lru_.size() >= canvas_tile_cache_size) {
+        tiles_.erase(tiles_lru_.back().first);
+        tiles_lru_.pop_back();
+    }
+
+    tiles_lru_.emplace_front(key, CanvasTile(tile_x * canvas_tile_cols * sym_width,
+                                             tile_y * canvas_tile_rows * sym_height,
+                                             canvas_tile_cols * sym_width,
+                                             canvas_tile_rows * sym_height));
+    tiles_.emplace(key, tiles_lru_.begin());
+
+    // rasterise elements intersecting the tile in the order they were added
+    auto &tile = tiles_lru_.front().second;
+    if (elems_ != nullptr && tile_y >= 0 && static_cast<size_t>(tile_y) < tile_rows_.size()) {
+        for (auto idx : tile_rows_[tile_y]) {
+            auto &elem = *(*elems_)[idx];
+            if (tile.Intersects(elem.GetBounds(*layout_)))
+                elem.Draw(tile, *layout_);
         }
+    }
+
+    return tile;
+}
+
+// Compose @row of the viewport span by span, every span is covered by a single tile
+void ScrollableCanvas::ComposeRow(const int row) const
+{
+    const int cy = row + frame_.y_off_;
+    auto *dst = frame_.pixels_.data() + row * frame_.dimx_;
+
+    for (int x = 0; x < frame_.dimx_;) {
+        const int cx = x + frame_.x_off_;
+        const auto &tile = GetTile(cx / canvas_tile_cols, cy / canvas_tile_rows);
+        const int span_end = std::min(frame_.dimx_, x + canvas_tile_cols - cx % canvas_tile_cols);
+
+        for (; x < span_end; ++x)
+            dst[x] = tile.GetPixel((x + frame_.x_off_) % canvas_tile_cols, cy % canvas_tile_rows);
+    }
+}
 
-        if (!dev->ids_names_[pci::DEVICE].empty()) {
-            auto device_name = std::format("{}", dev->ids_names_[pci::DEVICE]);
-            if (device_name.length() > max_hlen)
-                max_hlen = device_name.length();
-            text_data_.push_back(std::move(device_name));
+void ScrollableCanvas::Blit(ftxui::Screen &screen, const ftxui::Box &box) const
+{
+    const int dimy = std::max(0, std::min(height_ / sym_height, box.y_max - box.y_min + 1));
+    const int dimx = std::max(0, std::min(width_ / sym_width, box.x_max - box.x_min + 1));
+    auto &stale = frame_.stale_rows_;
+
+    if (!frame_.valid_ || frame_.dimx_ != dimx || frame_.dimy_ != dimy ||
+        frame_.x_off_ != area_.off_x_) {
+        frame_.pixels_.assign(dimx * dimy, ftxui::Pixel());
+        stale.assign(dimy, 1);
+    } else {
+        stale.assign(dimy, 0);
+
+        // vertical scroll: reuse the rows which are still visible
+        const int dy = area_.off_y_ - frame_.y_off_;
+        if (std::abs(dy) >= dimy) {
+            std::ranges::fill(stale, 1);
+        } else if (dy > 0) {
+            std::move(frame_.pixels_.begin() + dy * dimx, frame_.pixels_.end(),
+                      frame_.pixels_.begin());
+            std::fill(stale.end() - dy, stale.end(), 1);
+        } else if (dy < 0) {
+            std::move_backward(frame_.pixels_.begin(), frame_.pixels_.end() + dy * dimx,
+                               frame_.pixels_.end());
+            std::fill(stale.begin(), stale.begin() - dy, 1);
         }
+
+        for (auto row : damaged_rows_)
+            if (row >= area_.off_y_ && row < area_.off_y_ + dimy)
+                stale[row - area_.off_y_] = 1;
     }
+    damaged_rows_.clear();
 
-    // symbol width is 2 pixels + 2 pixel on both sides
-    max_hlen = max_hlen * sym_width + 2 * 2;
-    // symbol height is 4 pixels
-    max_vlen = text_data_.size() * sym_height + 2;
+    frame_.valid_ = true;
+    frame_.x_off_ = area_.off_x_;
+    frame_.y_off_ = area_.off_y_;
+    frame_.dimx_ = dimx;
+    frame_.dimy_ = dimy;
 
-    auto x_ = x + 1;
-    auto y_ = y + 3;
+    for (int y = 0; y < dimy; ++y) {
+        if (stale[y])
+            ComposeRow(y);
 
-    // save box coordinates
-    points_ = { x_, y_, max_hlen, max_vlen };
+        const auto *src = frame_.pixels_.data() + y * dimx;
+        for (int x = 0; x < dimx; ++x)
+            screen.PixelAt(box.x_min + x, box.y_min + y) = src[x];
+    }
 }
 
+PointDesc CanvasElemBox::GetConnPosParent(ShapeDesc box) noexcept
+{
+    auto [x, y, len, height] = box;
+    return { x + 4, y + height };
+}
 
+PointDesc CanvasElemBox::GetConnPosChild(ShapeDesc box) noexcept
+{
+    auto [x, y, len, height] = box;
+    return { x, y + height / 2 };
+}
 
-uint16_t CanvasElemPCIDev::GetHeight() noexcept
+void CanvasElemConnector::Layout(TopoLayout &layout) const
 {
-    return (text_data_.size() + 2) * 4;
+    auto parent_conn_pos = CanvasElemBox::GetConnPosParent(layout.boxes_[parent_box_]);
+    auto line = layout.lines_.begin() + first_line_;
+
+    for (auto child_box : child_boxes_) {
+        auto child_conn_pos = CanvasElemBox::GetConnPosChild(layout.boxes_[child_box]);
+        *line++ = { { parent_conn_pos.first, child_conn_pos.second }, child_conn_pos };
+    }
+
+    // vertical line from the parent down to the last child
+    auto last_child_conn_pos = CanvasElemBox::GetConnPosChild(layout.boxes_[child_boxes_.back()]);
+    *line = { parent_conn_pos, { parent_conn_pos.first, last_child_conn_pos.second } };
 }
 
-PointDesc CanvasElemPCIDev::GetConnPosParent() noexcept
+ShapeDesc CanvasElemConnector::GetBounds(const TopoLayout &layout) const noexcept
 {
-    auto x_pos = std::get<0>(points_) + 4;
-    auto y_pos = std::get<1>(points_) + std::get<3>(points_);
-    return { x_pos, y_pos };
+    int x_min = INT_MAX, y_min = INT_MAX, x_max = 0, y_max = 0;
+    for (const auto &[p1, p2] : std::span(layout.lines_).subspan(first_line_, LinesCnt())) {
+        x_min = std::min({x_min, p1.first, p2.first});
+        x_max = std::max({x_max, p1.first, p2.first});
+        y_min = std::min({y_min, p1.second, p2.second});
+        y_max = std::max({y_max, p1.second, p2.second});
+    }
+
+    return {x_min, y_min, x_max - x_min, y_max - y_min};
 }
 
-PointDesc CanvasElemPCIDev::GetConnPosChild() noexcept
+void CanvasElemConnector::Draw(CanvasTile &canvas, const TopoLayout &layout)
 {
-    auto x_pos = std::get<0>(points_);
-    auto y_pos = std::get<1>(points_) + std::get<3>(points_) / 2;
-    return { x_pos, y_pos };
+    for (const auto &line_desc : std::span(layout.lines_).subspan(first_line_, LinesCnt())) {
+        auto [p1, p2] = line_desc;
+        auto [x1, y1] = p1;
+        auto [x2, y2] = p2;
+        canvas.DrawPointLine(x1, y1, x2, y2);
+    }
+}
+
+// Text is formatted once for all the representation modes
+CanvasElemPCIDev::CanvasElemPCIDev(pci::PciDevBase *dev)
+    : dev_(dev), selected_(false), has_highlighted_regs_(false)
+{
+    // initialize text array
+    text_data_.push_back(std::format("{} | [{:04x}:{:04x}]", dev->DevIdStr(),
+                                     dev->get_vendor_id(), dev->get_device_id()));
+
+    if (!dev->ids_names_[pci::VENDOR].empty())
+        text_data_.push_back(std::format("{}", dev->ids_names_[pci::VENDOR]));
+
+    if (!dev->ids_names_[pci::DEVICE].empty())
+        text_data_.push_back(std::format("{}", dev->ids_names_[pci::DEVICE]));
+}
+
+void CanvasElemPCIDev::SetFoldState(bool collapsible, bool collapsed, size_t hidden_cnt)
+{
+    if (!collapsible)
+        fold_mark_.clear();
+    else
+        fold_mark_ = collapsed ? std::format(" [+{}]", hidden_cnt) : " [-]";
 }
 
-ShapeDesc CanvasElemPCIDev::GetShapeDesc() noexcept
+PointDesc CanvasElemPCIDev::GetSize(ElemReprMode mode) const noexcept
 {
-    return points_;
+    auto lines = GetTextLines(mode);
+    size_t max_hlen = text_data_[0].length() + fold_mark_.length();
+    for (size_t i = 1; i < lines; i++)
+        max_hlen = std::max(max_hlen, text_data_[i].length());
+
+    // symbol width is 2 pixels + 2 pixel on both sides,
+    // symbol height is 4 pixels
+    return { max_hlen * sym_width + 2 * 2, lines * sym_height + 2 };
 }
 
-void CanvasElemPCIDev::Draw(ScrollableCanvas &canvas)
+uint16_t CanvasElemPCIDev::GetAdvance(ElemReprMode mode) const noexcept
 {
-    // draw box
+    return (GetTextLines(mode) + 2) * 4;
+}
+
+void CanvasElemPCIDev::DrawOutline(CanvasTile &canvas, const TopoLayout &layout)
+{
+    const auto points = layout.boxes_[box_idx_];
+
     if (selected_) {
-        canvas.DrawBoxLine(points_, [](Pixel &p) {
+        canvas.DrawBoxLine(points, [](Pixel &p) {
             p.foreground_color = Color::Palette256::Orange1;
             p.bold = true;
         });
     } else if (has_highlighted_regs_) {
-        canvas.DrawBoxLine(points_, [](Pixel &p) {
+        canvas.DrawBoxLine(points, [](Pixel &p) {
             p.foreground_color = Color::Cyan;
             p.bold = false;
         });
     } else {
         // to remove element highlight, 'inverse' highlight style has to
         // be explicitly specified
-        canvas.DrawBoxLine(points_, [](Pixel &p) {
+        canvas.DrawBoxLine(points, [](Pixel &p) {
             p.foreground_color = Color::Default;
             p.bold = false;
         });
 
     }
+}
+
+void CanvasElemPCIDev::Draw(CanvasTile &canvas, const TopoLayout &layout)
+{
+    const auto points = layout.boxes_[box_idx_];
+
+    DrawOutline(canvas, layout);
 
     // draw text
-    auto x1 = std::get<0>(points_);
-    auto y1 = std::get<1>(points_);
+    auto x1 = std::get<0>(points);
+    auto y1 = std::get<1>(points);
     x1 += 4;
     y1 += 4;
 
-    for (size_t i = 0; const auto &text_str : text_data_) {
-        if (i++ == 0)
-            canvas.DrawText(x1, y1, text_str, [](Pixel &p) {
+    if (!fold_mark_.empty()) {
+        canvas.DrawText(x1 + text_data_[0].length() * sym_width, y1, fold_mark_, [](Pixel &p) {
+            p.bold = true;
+            p.foreground_color = Color::Yellow;
+        });
+    }
+
+    for (size_t i = 0; i < GetTextLines(layout.mode_); i++) {
+        if (i == 0)
+            canvas.DrawText(x1, y1, text_data_[i], [](Pixel &p) {
                 p.bold = true;
             });
         else
-            canvas.DrawText(x1, y1, text_str);
+            canvas.DrawText(x1, y1, text_data_[i]);
 
         y1 += 4;
     }
 }
 
-CanvasElemBus::CanvasElemBus(const pci::PCIBus &bus, uint16_t x, uint16_t y)
+CanvasElemBus::CanvasElemBus(const pci::PCIBus &bus)
     : bus_id_str_(std::format("[ {:04x}:{:02x} ]", bus.dom_, bus.bus_nr_))
+{}
+
+PointDesc CanvasElemBus::GetSize([[maybe_unused]] ElemReprMode mode) const noexcept
 {
-    auto hlen = bus_id_str_.length() * sym_width + 2 * 2;
-    auto vlen = sym_height + 2;
-    points_ = { x + 1, y + 3, hlen, vlen };
+    return { bus_id_str_.length() * sym_width + 2 * 2, sym_height + 2 };
 }
 
-PointDesc CanvasElemBus::GetConnPos() noexcept
+uint16_t CanvasElemBus::GetAdvance([[maybe_unused]] ElemReprMode mode) const noexcept
 {
-    auto x_pos = std::get<0>(points_) + 4;
-    auto y_pos = std::get<1>(points_) + std::get<3>(points_);
-    return { x_pos, y_pos };
+    return (1 + 2) * 4;
 }
 
-void CanvasElemBus::Draw(ScrollableCanvas &canvas)
+void CanvasElemBus::Draw(CanvasTile &canvas, const TopoLayout &layout)
 {
-    canvas.DrawBoxLine(points_, [](Pixel &p) {
+    const auto points = layout.boxes_[box_idx_];
+
+    canvas.DrawBoxLine(points, [](Pixel &p) {
         p.bold = true;
         p.foreground_color = Color::Magenta;
     });
 
-    auto x1 = std::get<0>(points_);
-    auto y1 = std::get<1>(points_);
+    auto x1 = std::get<0>(points);
+    auto y1 = std::get<1>(points);
     x1 += 4;
     y1 += 4;
     canvas.DrawText(x1, y1, bus_id_str_, [](Pixel &p) {
@@ -261,25 +450,36 @@ void CanvasElemBus::Draw(ScrollableCanvas &canvas)
     });
 }
 
-CanvasElemMode::CanvasElemMode(bool is_live, uint16_t x, uint16_t y) :
+CanvasElemMode::CanvasElemMode(bool is_live, std::optional<size_t> loaded_cnt) :
     is_live_(is_live),
     mode_text_(std::format("mode -> [{}]", is_live ? "LIVE" : "SNAPSHOT"))
 {
-    auto hlen = mode_text_.length() * sym_width + 2 * 2;
-    auto vlen = sym_height + 2;
-    points_ = { x + 1, y + 3, hlen, vlen };
+    if (loaded_cnt)
+        mode_text_ += std::format(" loading: {} devices", *loaded_cnt);
 }
 
-void CanvasElemMode::Draw(ScrollableCanvas &canvas)
+PointDesc CanvasElemMode::GetSize([[maybe_unused]] ElemReprMode mode) const noexcept
 {
-    canvas.DrawBoxLine(points_, [](Pixel &p) {
+    return { mode_text_.length() * sym_width + 2 * 2, sym_height + 2 };
+}
+
+uint16_t CanvasElemMode::GetAdvance([[maybe_unused]] ElemReprMode mode) const noexcept
+{
+    return (1 + 2) * 4;
+}
+
+void CanvasElemMode::Draw(CanvasTile &canvas, const TopoLayout &layout)
+{
+    const auto points = layout.boxes_[box_idx_];
+
+    canvas.DrawBoxLine(points, [](Pixel &p) {
         p.bold = true;
         p.dim = true;
         p.foreground_color = Color::Blue;
     });
 
-    auto x1 = std::get<0>(points_);
-    auto y1 = std::get<1>(points_);
+    auto x1 = std::get<0>(points);
+    auto y1 = std::get<1>(points);
     x1 += 4;
     y1 += 4;
     canvas.DrawText(x1, y1, mode_text_, [](Pixel &p) {
@@ -293,91 +493,95 @@ void CanvasElemMode::Draw(ScrollableCanvas &canvas)
 
 // mouse click tracking stuff
 
-bool CanvasDevBlockMap::Insert(std::shared_ptr<CanvasElemPCIDev> dev)
+bool CanvasDevBlockMap::Insert(CanvasElemPCIDev *dev)
 {
-    auto [x, y, len, height] = dev->GetShapeDesc();
-    auto res = blocks_y_dim_.insert({{y, height}, dev});
-    return res.second;
+    auto [x, y, len, height] = dev->GetBounds(*layout_);
+    if (!y_.empty() && y <= y_.back())
+        return false;
+
+    y_.push_back(y);
+    height_.push_back(height);
+    x_.push_back(x);
+    len_.push_back(len);
+    devs_.push_back(dev);
+    return true;
 }
 
-void CanvasDevBlockMap::SelectDeviceByPos(const uint16_t mouse_x, const uint16_t mouse_y,
-                                     ScrollableCanvas &canvas, bool highlighted_regs)
+size_t CanvasDevBlockMap::FindByY(const int y) const noexcept
 {
-    auto y_iter = blocks_y_dim_.lower_bound({mouse_y * 4, 0});
-    y_iter--;
-
-    if (y_iter != blocks_y_dim_.end())
-    {
-        auto [x, y, len, height] = y_iter->second->GetShapeDesc();
-        auto x_in_pixels = mouse_x * sym_width;
+    if (y_.empty())
+        return npos;
+
+    // branchless binary search, the loop only depends on the array size
+    const int *base = y_.data();
+    size_t n = y_.size();
+    while (n > 1) {
+        const size_t half = n / 2;
+        base = base[half] <= y ? base + half : base;
+        n -= half;
+    }
 
-        if (x_in_pixels >= x && x_in_pixels <= x + len) {
-            if (selected_dev_iter_ != y_iter) {
-                selected_dev_iter_->second->selected_ = false;
-                selected_dev_iter_->second->has_highlighted_regs_ = highlighted_regs;
-                // redraw previously selected element since it's not selected now
-                selected_dev_iter_->second->Draw(canvas);
+    return *base <= y ? base - y_.data() : npos;
+}
 
-                selected_dev_iter_ = y_iter;
-                selected_dev_iter_->second->selected_ = true;
+CanvasElemPCIDev *CanvasDevBlockMap::Select(size_t idx, bool highlighted_regs)
+{
+    if (idx == selected_)
+        return nullptr;
 
-                // redraw newly selected element
-                selected_dev_iter_->second->Draw(canvas);
-            }
-        }
+    auto prev_selected = Selected();
+    if (prev_selected != nullptr) {
+        prev_selected->selected_ = false;
+        prev_selected->has_highlighted_regs_ = highlighted_regs;
     }
+
+    selected_ = idx;
+    devs_[selected_]->selected_ = true;
+    return prev_selected;
 }
 
-void CanvasDevBlockMap::SelectNextPrevDevice(ScrollableCanvas &canvas,
-                                             bool highlighted_regs,
-                                             bool select_next)
+CanvasElemPCIDev *
+CanvasDevBlockMap::SelectDeviceByPos(const int mouse_x, const int mouse_y,
+                                     bool highlighted_regs)
 {
-    if (select_next) { // move selector to next device
-        auto it_next = std::next(selected_dev_iter_);
-        if (it_next != blocks_y_dim_.end()) {
-            selected_dev_iter_->second->selected_ = false;
-            selected_dev_iter_->second->has_highlighted_regs_ = highlighted_regs;
-            selected_dev_iter_->second->Draw(canvas);
-
-            selected_dev_iter_ = it_next;
-            selected_dev_iter_->second->selected_ = true;
-            selected_dev_iter_->second->Draw(canvas);
-        }
-    } else { // move selector to previous device
-        if (selected_dev_iter_ != blocks_y_dim_.begin()) {
-            selected_dev_iter_->second->selected_ = false;
-            selected_dev_iter_->second->has_highlighted_regs_ = highlighted_regs;
-            selected_dev_iter_->second->Draw(canvas);
+    // mouse position is in cells, the cell covers [sym_width x sym_height] dots
+    const int y_in_pixels = mouse_y * sym_height;
+    const int x_in_pixels = mouse_x * sym_width;
 
-            selected_dev_iter_--;
+    auto idx = FindByY(y_in_pixels + sym_height - 1);
+    if (idx == npos)
+        return nullptr;
 
-            selected_dev_iter_->second->selected_ = true;
-            selected_dev_iter_->second->Draw(canvas);
-        }
-    }
+    if (y_in_pixels > y_[idx] + height_[idx] ||
+        x_in_pixels + sym_width - 1 < x_[idx] || x_in_pixels > x_[idx] + len_[idx])
+        return nullptr;
+
+    return Select(idx, highlighted_regs);
 }
 
-// Restore highlighing state for all the devices.
-void CanvasDevBlockMap::ReapplyHighlight()
+CanvasElemPCIDev *
+CanvasDevBlockMap::SelectNextPrevDevice(bool highlighted_regs, bool select_next)
 {
-    if (!regs_highlighted_elems_.empty()) {
-        assert(blocks_y_dim_.size() == regs_highlighted_elems_.size());
-        for (int i = 0; auto block_elem : blocks_y_dim_)
-            block_elem.second->has_highlighted_regs_ = regs_highlighted_elems_[i++];
+    if (selected_ == npos)
+        return nullptr;
+
+    if (select_next) { // move selector to next device
+        if (selected_ + 1 == devs_.size())
+            return nullptr;
+        return Select(selected_ + 1, highlighted_regs);
+    } else { // move selector to previous device
+        if (selected_ == 0)
+            return nullptr;
+        return Select(selected_ - 1, highlighted_regs);
     }
 }
 
-void CanvasDevBlockMap::Reset()
+// Point the selector to @dev, which has been selected in another mode
+void CanvasDevBlockMap::SyncSelection(const CanvasElemPCIDev &dev)
 {
-    // temporarily preserve currently selected device
-    selected_dev_ = selected_dev_iter_->second;
-
-    // Preserve devices highlight state on drawing mode switch
-    regs_highlighted_elems_.clear();
-    for (const auto &c_elem : std::views::values(blocks_y_dim_))
-        regs_highlighted_elems_.push_back(c_elem->has_highlighted_regs_);
-
-    blocks_y_dim_.clear();
+    auto [x, y, len, height] = dev.GetBounds(*layout_);
+    auto idx = FindByY(y);
+    selected_ = (idx != npos && y_[idx] == y) ? idx : npos;
 }
 
 // UI topology element impl
@@ -410,8 +614,9 @@ Element PCITopoUIComp::OnRender()
                       is_active ? ftxui::select :
                       ftxui::nothing;
 
-    return scrollable_canvas(canvas_) |
-           focus_mgmt | size(WIDTH, LESS_THAN, max_width_) |
+    // pass the canvas by pointer, so rasterised tiles are not copied on every frame
+    return scrollable_canvas(&CurMode().canvas_) |
+           focus_mgmt | size(WIDTH, LESS_THAN, CurMode().canvas_.width() / sym_width) |
            reflect(box_);
 }
 
@@ -431,7 +636,7 @@ bool PCITopoUIComp::OnEvent(Event event)
             return false;
     }
 
-    auto area = canvas_.GetVisibleAreaDesc();
+    auto area = CurMode().canvas_.GetVisibleAreaDesc();
 
     if (event.is_mouse()) {
         //logger.log(Verbosity::INFO, "PCITopoUIComp -> mouse event: shift {} meta {} ctrl {}",
@@ -452,12 +657,10 @@ bool PCITopoUIComp::OnEvent(Event event)
         }
 
         if (event.mouse().button == Mouse::Left) {
-            block_map_.SelectDeviceByPos(event.mouse().x + area->off_x_,
-                                         event.mouse().y + area->off_y_,
-                                         canvas_,
-                                         regs_comp_->CurDevHaveRegsHighlighted());
-            // update state of PCIRegsComponent
-            regs_comp_->UpdateSelectedDev(block_map_.selected_dev_iter_->second->dev_);
+            UpdateSelection(CurMode().block_map_.SelectDeviceByPos(
+                                event.mouse().x + area->off_x_,
+                                event.mouse().y + area->off_y_,
+                                regs_comp_->CurDevHaveRegsHighlighted()));
         }
 
         return true;
@@ -489,20 +692,20 @@ bool PCITopoUIComp::OnEvent(Event event)
             break;
         // select next/prev device via 'j'/'k' + shift
         case 'J':
-            block_map_.SelectNextPrevDevice(canvas_,
-                                            regs_comp_->CurDevHaveRegsHighlighted(),
-                                            true);
-            regs_comp_->UpdateSelectedDev(block_map_.selected_dev_iter_->second->dev_);
+            UpdateSelection(CurMode().block_map_.SelectNextPrevDevice(
+                                regs_comp_->CurDevHaveRegsHighlighted(), true));
             break;
         case 'K':
-            block_map_.SelectNextPrevDevice(canvas_,
-                                            regs_comp_->CurDevHaveRegsHighlighted(),
-                                            false);
-            regs_comp_->UpdateSelectedDev(block_map_.selected_dev_iter_->second->dev_);
+            UpdateSelection(CurMode().block_map_.SelectNextPrevDevice(
+                                regs_comp_->CurDevHaveRegsHighlighted(), false));
             break;
         case 'r':
             regs_comp_->ResetRegsVisibilityState();
             break;
+        // collapse/expand subtree of the selected device
+        case ' ':
+            ToggleCollapsed();
+            break;
         default:
             break;
         }
@@ -510,6 +713,11 @@ bool PCITopoUIComp::OnEvent(Event event)
         return true;
     }
 
+    if (event == Event::Return) {
+        ToggleCollapsed();
+        return true;
+    }
+
     // special events handlers
 
     // scroll across the canvas with arrows
@@ -536,18 +744,14 @@ bool PCITopoUIComp::OnEvent(Event event)
 
     // select next/prev device via Ctrl + 'Up'/'Down'
     if (event == Event::ArrowUpCtrl) {
-        block_map_.SelectNextPrevDevice(canvas_,
-                                        regs_comp_->CurDevHaveRegsHighlighted(),
-                                        false);
-        regs_comp_->UpdateSelectedDev(block_map_.selected_dev_iter_->second->dev_);
+        UpdateSelection(CurMode().block_map_.SelectNextPrevDevice(
+                            regs_comp_->CurDevHaveRegsHighlighted(), false));
         return true;
     }
 
     if (event == Event::ArrowDownCtrl) {
-        block_map_.SelectNextPrevDevice(canvas_,
-                                        regs_comp_->CurDevHaveRegsHighlighted(),
-                                        true);
-        regs_comp_->UpdateSelectedDev(block_map_.selected_dev_iter_->second->dev_);
+        UpdateSelection(CurMode().block_map_.SelectNextPrevDevice(
+                            regs_comp_->CurDevHaveRegsHighlighted(), true));
         return true;
     }
 
@@ -555,161 +759,331 @@ bool PCITopoUIComp::OnEvent(Event event)
     return false;
 }
 
-void PCITopoUIComp::AddTopologyElements()
+void PCITopoUIComp::AddBoxElem(std::shared_ptr<CanvasElemBox> elem, uint16_t depth)
 {
-    // Add current operation mode info box
-    auto mode_sign = std::make_shared<CanvasElemMode>(topo_ctx_.live_mode_, 2, 0);
-    canvas_elems_.push_back(std::move(mode_sign));
+    elem->box_idx_ = box_elems_.size();
+    elem->depth_ = depth;
+    box_elems_.push_back(elem.get());
+    canvas_elems_.push_back(std::move(elem));
+}
 
-    uint16_t x = 2, y = 12;
+// Bridges subtrees are expanded, while VF groups are collapsed unless
+// configured otherwise
+void PCITopoUIComp::InitCollapsedState()
+{
+    collapsed_.assign(topo_ctx_.devs_.size(), 0);
 
-    for (const auto &bus : topo_ctx_.buses_) {
-        if (bus.second.is_root_) {
-            auto conn_pos = AddRootBus(bus.second, &x, &y);
-            AddBusDevices(bus.second, topo_ctx_.buses_, conn_pos, x + child_elem_xoff, &y);
+    if (pciex_cfg.tui.dt_dflt_collapse_vfs) {
+        for (const auto &[pf_idx, vfs] : topo_ctx_.virt_fns_)
+            collapsed_[pf_idx] = 1;
+    }
+}
+
+// Build mode independent topology elements in the order they are laid out on canvas.
+// Only the devices outside of the collapsed subtrees get their elements.
+void PCITopoUIComp::BuildTopologyElements(DevElemsByDev &prev_elems)
+{
+    // Add current operation mode info box
+    auto loaded_cnt = loading_ ? std::optional(loaded_cnt_) : std::nullopt;
+    AddBoxElem(std::make_shared<CanvasElemMode>(topo_ctx_.live_mode_, loaded_cnt), 0);
+
+    if (loading_) {
+        for (const auto &[key, bus] : loading_buses_) {
+            auto bus_idx = box_elems_.size();
+            AddBoxElem(std::make_shared<CanvasElemBus>(bus), 0);
+            AddBusDevices(bus, bus_idx, 1, prev_elems);
         }
+        return;
     }
 
-    max_width_ = (max_width_ + 4) / sym_width;
-    canvas_.VisibleAreaSetMax(max_width_, canvas_.height() / 4);
+    for (const auto &bus : topo_ctx_.buses_) {
+        if (bus.is_root_) {
+            auto root_bus = std::make_shared<CanvasElemBus>(bus);
+            auto root_bus_idx = box_elems_.size();
+            AddBoxElem(std::move(root_bus), 0);
+            AddBusDevices(bus, root_bus_idx, 1, prev_elems);
+        }
+    }
+}
 
-    // select element
-    if (block_map_.selected_dev_iter_ == block_map_.blocks_y_dim_.end()) {
-        block_map_.selected_dev_iter_ = block_map_.blocks_y_dim_.begin();
-        block_map_.selected_dev_iter_->second->selected_ = true;
+// Number of devices, which are hidden once @dev is collapsed.
+// VFs are counted by their PF even if they reside on another bus.
+size_t PCITopoUIComp::GetSubtreeSize(const pci::PciDevBase *dev) const noexcept
+{
+    if (dev->type_ == pci::pci_dev_type::TYPE1)
+        return topo_ctx_.tree_.Subtree(dev->topo_idx_).size() - 1;
+    return topo_ctx_.GetVirtFns(dev).size();
+}
 
-        // update state of PCIRegsComponent
-        regs_comp_->UpdateSelectedDev(block_map_.selected_dev_iter_->second->dev_);
+// Returns box index of the device element. Element is reused if the device
+// has been visible before the rebuild, otherwise it's constructed.
+uint32_t PCITopoUIComp::AddDevElem(pci::PciDevBase *dev, uint16_t depth,
+                                   DevElemsByDev &prev_elems)
+{
+    std::shared_ptr<CanvasElemPCIDev> device;
+    if (auto node = prev_elems.extract(dev); !node.empty()) {
+        device = std::move(node.mapped());
     } else {
-        auto cur_dev = block_map_.selected_dev_->dev_;
-        for (auto it = block_map_.blocks_y_dim_.begin();
-                    it != block_map_.blocks_y_dim_.end(); it++) {
-            if (it->second->dev_ == cur_dev) {
-                block_map_.selected_dev_iter_ = it;
-                block_map_.selected_dev_iter_->second->selected_ = true;
-                regs_comp_->UpdateSelectedDev(
-                        block_map_.selected_dev_iter_->second->dev_);
-                break;
-            }
-        }
+        device = std::make_shared<CanvasElemPCIDev>(dev);
+        device->has_highlighted_regs_ = regs_comp_->DevHaveRegsHighlighted(dev->dev_id_);
+    }
 
+    if (!loading_) {
+        const auto subtree_cnt = GetSubtreeSize(dev);
+        device->SetFoldState(subtree_cnt != 0, collapsed_[dev->topo_idx_], subtree_cnt);
     }
 
-    block_map_.ReapplyHighlight();
-    DrawElements();
+    auto dev_box = box_elems_.size();
+    dev_elems_.push_back(device);
+    AddBoxElem(std::move(device), depth);
+    return dev_box;
 }
 
-void PCITopoUIComp::DrawElements() noexcept
+void PCITopoUIComp::AddConnector(std::shared_ptr<CanvasElemConnector> connector)
 {
-    for (const auto &ce : canvas_elems_)
-        ce->Draw(canvas_);
+    if (connector->child_boxes_.empty())
+        return;
+
+    connector->first_line_ = lines_cnt_;
+    lines_cnt_ += connector->LinesCnt();
+    connectors_.push_back(connector.get());
+    canvas_elems_.push_back(std::move(connector));
 }
 
-std::pair<PointDesc, PointDesc>
-PCITopoUIComp::AddDevice(std::shared_ptr<pci::PciDevBase> dev, uint16_t x, uint16_t *y)
+void PCITopoUIComp::AddBusDevices(const pci::PCIBus &current_bus,
+                                  uint32_t parent_box, uint16_t depth,
+                                  DevElemsByDev &prev_elems)
 {
-    auto device = std::make_shared<CanvasElemPCIDev>(dev, current_drawing_mode_, x, *y);
-    std::pair<PointDesc, PointDesc> conn_pos_pair {device->GetConnPosChild(),
-                                                   device->GetConnPosParent()};
-    *y += device->GetHeight();
-    if (!block_map_.Insert(device))
-        logger.log(Verbosity::WARN, "Failed to add {} device to block tracking map", dev->dev_id_str_);
+    auto bus_connector = std::make_shared<CanvasElemConnector>(parent_box);
 
-    // figure out max width of useful data on canvas
-    auto dev_xpos = std::get<0>(device->points_);
-    auto dev_width = std::get<2>(device->points_);
-    if ((dev_xpos + dev_width) > max_width_)
-        max_width_ = dev_xpos + dev_width;
+    for (const auto &dev : current_bus.devs_) {
+        if (loading_)
+            bus_connector->child_boxes_.push_back(AddDevElem(dev, depth, prev_elems));
+        else
+            AddDevNode(dev, depth, *bus_connector, prev_elems);
+    }
 
-    canvas_elems_.push_back(std::move(device));
-    return conn_pos_pair;
+    AddConnector(std::move(bus_connector));
 }
 
-PointDesc
-PCITopoUIComp::AddRootBus(const pci::PCIBus &bus, uint16_t *x, uint16_t *y)
+// Add @dev connected by @connector to its parent along with its subtree
+void PCITopoUIComp::AddDevNode(pci::PciDevBase *dev, uint16_t depth,
+                               CanvasElemConnector &connector, DevElemsByDev &prev_elems)
 {
-    auto root_bus = std::make_shared<CanvasElemBus>(bus, *x, *y);
-    auto conn_pos = root_bus->GetConnPos();
-    canvas_elems_.push_back(std::move(root_bus));
-    *y += (1 + 2) * 4;
+    // VFs are grouped under their PF
+    if (topo_ctx_.GetPhysFn(dev) != nullptr)
+        return;
+
+    auto dev_box = AddDevElem(dev, depth, prev_elems);
+    connector.child_boxes_.push_back(dev_box);
 
-    return conn_pos;
+    if (!collapsed_[dev->topo_idx_])
+        AddDevChildren(dev, dev_box, depth + 1, prev_elems);
 }
 
-void PCITopoUIComp::AddBusDevices(const pci::PCIBus &current_bus,
-                                  const std::map<uint16_t, pci::PCIBus> &bus_map,
-                                  PointDesc parent_conn_pos,
-                                  uint16_t x_off, uint16_t *y_off)
+// Add devices behind the bridge or VFs of SR-IOV PF
+void PCITopoUIComp::AddDevChildren(pci::PciDevBase *dev, uint32_t dev_box, uint16_t depth,
+                                   DevElemsByDev &prev_elems)
 {
-    auto bus_connector = std::make_shared<CanvasElemConnector>();
+    auto connector = std::make_shared<CanvasElemConnector>(dev_box);
 
-    for (const auto &dev : current_bus.devs_) {
-        auto [conn_pos_as_child, conn_pos_as_parent] = AddDevice(dev, x_off, y_off);
+    topo_ctx_.tree_.ForEachChild(dev->topo_idx_, [&](uint32_t child) {
+        AddDevNode(topo_ctx_.devs_[child], depth, *connector, prev_elems);
+    });
 
-        bus_connector->AddLine({ { parent_conn_pos.first, conn_pos_as_child.second },
-                                 { conn_pos_as_child.first, conn_pos_as_child.second } });
+    for (auto vf : topo_ctx_.GetVirtFns(dev))
+        connector->child_boxes_.push_back(AddDevElem(vf, depth, prev_elems));
 
-        if (dev->type_ == pci::pci_dev_type::TYPE1) {
-            auto type1_dev = dynamic_cast<pci::PciType1Dev *>(dev.get());
-            auto sec_bus_iter = bus_map.find(type1_dev->get_sec_bus_num());
-            if (sec_bus_iter != bus_map.end()) {
-                AddBusDevices(sec_bus_iter->second, bus_map, conn_pos_as_parent,
-                              x_off + 16, y_off);
-            }
-        }
+    AddConnector(std::move(connector));
+}
+
+// Compute geometry of all the elements for the representation @mode
+void PCITopoUIComp::LayoutElements(ElemReprMode mode, TopoLayout &layout) const
+{
+    layout.mode_ = mode;
+    layout.boxes_.resize(box_elems_.size());
+    layout.lines_.resize(lines_cnt_);
+    layout.x_max_ = layout.y_max_ = 0;
+
+    int y = 0;
+    for (const auto *elem : box_elems_) {
+        int x = 2 + elem->depth_ * child_elem_xoff;
+        auto [len, height] = elem->GetSize(mode);
+
+        layout.boxes_[elem->box_idx_] = { x + 1, y + 3, len, height };
+        layout.x_max_ = std::max(layout.x_max_, x + 1 + len);
+        layout.y_max_ = std::max(layout.y_max_, y + 3 + height);
+
+        y += elem->GetAdvance(mode);
     }
 
-    if (!bus_connector->lines_.empty()) {
-        auto last_line = bus_connector->lines_.back();
-        auto [x1_last, y1_last] = last_line.first;
+    for (const auto *conn : connectors_)
+        conn->Layout(layout);
+}
+
+// Everything depending on the representation mode is computed once,
+// so switching between the modes doesn't rebuild anything
+void PCITopoUIComp::LayoutModes()
+{
+    for (size_t i = 0; i < elem_repr_modes_cnt; i++) {
+        auto &mode_ctx = modes_[i];
+        LayoutElements(static_cast<ElemReprMode>(i), mode_ctx.layout_);
+
+        mode_ctx.block_map_ = {};
+        mode_ctx.block_map_.layout_ = &mode_ctx.layout_;
+        for (const auto &dev : dev_elems_) {
+            if (!mode_ctx.block_map_.Insert(dev.get()))
+                logger.log(Verbosity::WARN, "Failed to add {} device to block tracking map",
+                           dev->dev_->DevIdStr());
+        }
 
-        bus_connector->AddLine({ { parent_conn_pos.first, parent_conn_pos.second },
-                                 { x1_last, y1_last} });
-        canvas_elems_.push_back(std::move(bus_connector));
+        // Elements are rasterised lazily, only when the tiles they belong to get visible
+        mode_ctx.canvas_.SetElements(canvas_elems_, mode_ctx.layout_);
     }
 }
 
-void PCITopoUIComp::SwitchDrawingMode(ElemReprMode new_mode)
+void PCITopoUIComp::InitModes()
 {
-    if (current_drawing_mode_ == new_mode)
+    LayoutModes();
+    SelectFirstDev();
+}
+
+void PCITopoUIComp::SelectFirstDev()
+{
+    if (dev_elems_.empty())
         return;
 
-    current_drawing_mode_ = new_mode;
+    // select element
+    auto &first_dev = *dev_elems_.front();
+    first_dev.selected_ = true;
+    for (auto &mode_ctx : modes_)
+        mode_ctx.block_map_.SyncSelection(first_dev);
+
+    // update state of PCIRegsComponent
+    regs_comp_->UpdateSelectedDev(first_dev.dev_);
+}
+
+// Elements are shared between the modes, so the ones changed their selection
+// state have to be redrawn on every mode canvas
+void PCITopoUIComp::UpdateSelection(CanvasElemPCIDev *prev_selected)
+{
+    auto cur_selected = CurMode().block_map_.Selected();
+    if (cur_selected == nullptr)
+        return;
+
+    if (prev_selected != nullptr) {
+        for (auto &mode_ctx : modes_) {
+            mode_ctx.canvas_.RedrawOutline(*prev_selected);
+            mode_ctx.canvas_.RedrawOutline(*cur_selected);
+        }
+    }
+
+    // update state of PCIRegsComponent
+    regs_comp_->UpdateSelectedDev(cur_selected->dev_);
+}
+
+// Rebuild the elements once the collapsed state or the set of loaded devices
+// has changed. Elements of the devices staying visible are reused, the newly
+// exposed ones are constructed.
+void PCITopoUIComp::RebuildElements()
+{
+    auto selected = CurMode().block_map_.Selected();
+    const auto selected_dev = selected != nullptr ? selected->dev_ : nullptr;
+
+    // elements of the devices got hidden are released along with the map
+    DevElemsByDev prev_elems;
+    for (auto &dev : dev_elems_)
+        prev_elems.emplace(dev->dev_, std::move(dev));
 
-    block_map_.Reset();
     canvas_elems_.clear();
-    max_width_ = 0;
+    box_elems_.clear();
+    dev_elems_.clear();
+    connectors_.clear();
+    lines_cnt_ = 0;
+
+    BuildTopologyElements(prev_elems);
+    LayoutModes();
+
+    auto it = std::ranges::find(dev_elems_, selected_dev,
+                                [](const auto &dev) { return dev->dev_; });
+    if (it == dev_elems_.end()) {
+        // nothing has been loaded before
+        SelectFirstDev();
+        return;
+    }
 
-    auto [w, h] = GetCanvasSizeEstimate(topo_ctx_, current_drawing_mode_);
-    canvas_ = ScrollableCanvas(w, h);
+    for (auto &mode_ctx : modes_)
+        mode_ctx.block_map_.SyncSelection(**it);
+}
+
+// Devices are decoded in arbitrary order by populate workers,
+// so they're inserted into their bus lists in the DBDF order
+void PCITopoUIComp::AddLoadedDevices(std::span<pci::PciDevBase * const> devs)
+{
+    for (auto dev : devs) {
+        auto [it, _] = loading_buses_.try_emplace(pci::PCIBus::Key(dev->dom_, dev->bus_),
+                                                  dev->dom_, dev->bus_, false);
+        auto &bus_devs = it->second.devs_;
+        bus_devs.insert(std::ranges::upper_bound(bus_devs, dev->dev_id_, {},
+                                                 &pci::PciDevBase::dev_id_),
+                        dev);
+    }
+    loaded_cnt_ += devs.size();
 
-    AddTopologyElements();
+    RebuildElements();
 }
 
-// Returns approximate canvas size based on the actual topology
-// X, Y is in dots
-std::pair<uint16_t, uint16_t>
-GetCanvasSizeEstimate(const pci::PCITopologyCtx &ctx, ElemReprMode mode) noexcept
+void PCITopoUIComp::OnTopologyLoaded()
+{
+    loading_ = false;
+    loading_buses_.clear();
+    InitCollapsedState();
+
+    RebuildElements();
+}
+
+// Collapse/expand the bridge subtree or VF group of the selected device
+void PCITopoUIComp::ToggleCollapsed()
 {
-    uint16_t x_size = 0, y_size = 0;
-    uint16_t root_bus_elem_height = 3 * sym_height;
-    uint16_t dev_elem_height = mode == ElemReprMode::Verbose ?
-                                       5 * sym_height :
-                                       3 * sym_height;
+    auto selected = CurMode().block_map_.Selected();
+    if (loading_ || selected == nullptr || GetSubtreeSize(selected->dev_) == 0)
+        return;
+
+    const auto dev = selected->dev_;
+    auto &collapsed = collapsed_[dev->topo_idx_];
+    collapsed = !collapsed;
+
+    RebuildElements();
 
-    auto root_bus_num = std::ranges::count_if(ctx.buses_, [](auto bus) { return bus.second.is_root_; });
-    y_size += root_bus_num * root_bus_elem_height;
+    logger.log(Verbosity::INFO, "{} {}: {} device elements", dev->DevIdStr(),
+               collapsed ? "collapsed" : "expanded", dev_elems_.size());
+}
 
-    auto dev_cnt = ctx.devs_.size();
-    y_size += dev_cnt * dev_elem_height;
+void PCITopoUIComp::SwitchDrawingMode(ElemReprMode new_mode)
+{
+    if (current_drawing_mode_ == new_mode)
+        return;
 
-    y_size += 16;
+    auto &prev_block_map = CurMode().block_map_;
+    current_drawing_mode_ = new_mode;
 
-    // Width of the canvas depends on the actual devices placement,
-    // so it's a constant for now
-    x_size = 500;
-    logger.log(Verbosity::INFO, "Estimated canvas size: {} x {}", x_size, y_size);
+    if (auto selected = prev_block_map.Selected(); selected != nullptr)
+        CurMode().block_map_.SyncSelection(*selected);
+}
 
+// Returns exact canvas size out of the elements geometry.
+// Margins leave room for box borders drawn at the very edge of the extent.
+// X, Y is in dots
+std::pair<int, int> GetCanvasSize(const TopoLayout &layout) noexcept
+{
+    int x_size = layout.x_max_ + 2 * sym_width;
+    int y_size = layout.y_max_ + 2 * sym_height;
+
+    // round up to the whole cells
+    x_size = (x_size + sym_width - 1) / sym_width * sym_width;
+    y_size = (y_size + sym_height - 1) / sym_height * sym_height;
+
+    logger.log(Verbosity::INFO, "Canvas size: {} x {}", x_size, y_size);
     return {x_size, y_size};
 }
 
@@ -737,56 +1111,149 @@ GetCanvasSizeEstimate(const pci::PCITopologyCtx &ctx, ElemReprMode mode) noexcep
 //    return Make<FocusableComp>(elem);
 //}
 
-// scrollable component
-Element ScrollableComp::OnRender() {
+// Lays out only the items intersecting its box (plus overscan) once the box
+// is known. Items are expected to be measured already.
+// Draws a scroll indicator in the rightmost column.
+class VirtualListNode : public ftxui::Node
+{
+public:
+    VirtualListNode(std::vector<Element> items, std::vector<int> heights,
+                    int min_x, int top, int size)
+        : items_(std::move(items)), heights_(std::move(heights)),
+          min_x_(min_x), top_(top), size_(size)
+    {}
+
+    void ComputeRequirement() override
+    {
+        // the same way as frame does, the whole list height is requested,
+        // but the node is fine to be shrunk
+        requirement_ = {};
+        requirement_.min_x = min_x_ + 1;
+        requirement_.min_y = size_;
+        requirement_.flex_grow_y = requirement_.flex_shrink_y = 1;
+    }
+
+    void SetBox(Box box) override
+    {
+        Node::SetBox(box);
+
+        const int dimy = box.y_max - box.y_min + 1;
+        top_ = std::max(0, std::min(size_ - dimy, top_));
+
+        // first item intersecting the window
+        size_t first = 0;
+        int off = 0;
+        while (first < items_.size() && off + heights_[first] <= top_)
+            off += heights_[first++];
+
+        size_t last = first;
+        for (int end = off; last < items_.size() && end < top_ + dimy; last++)
+            end += heights_[last];
+
+        const size_t from = first > virt_list_overscan ? first - virt_list_overscan : 0;
+        const size_t to = std::min(items_.size(), last + virt_list_overscan);
+        for (size_t i = from; i < first; i++)
+            off -= heights_[i];
+
+        children_.clear();
+        children_.push_back(vbox(Elements(items_.begin() + from, items_.begin() + to)));
+        children_[0]->ComputeRequirement();
+
+        auto child_box = box;
+        child_box.x_max -= 1;
+        child_box.y_min -= top_ - off;
+        child_box.y_max = child_box.y_min + children_[0]->requirement().min_y - 1;
+        children_[0]->SetBox(child_box);
+    }
+
+    void Render(Screen &screen) override
+    {
+        const auto stencil = screen.stencil;
+        screen.stencil = Box::Intersection(box_, stencil);
+        children_[0]->Render(screen);
+
+        const int dimy = box_.y_max - box_.y_min + 1;
+        if (size_ > dimy) {
+            const int thumb_start = top_ * dimy / size_;
+            const int thumb_end = std::max(thumb_start + 1, (top_ + dimy) * dimy / size_);
+            for (int y = thumb_start; y < thumb_end && y < dimy; y++)
+                screen.PixelAt(box_.x_max, box_.y_min + y).character = "┃";
+        }
+
+        screen.stencil = stencil;
+    }
+
+private:
+    std::vector<Element> items_;
+    std::vector<int>     heights_;
+    int                  min_x_;
+    int                  top_;
+    int                  size_;
+};
+
+Element VirtualListComp::OnRender()
+{
     auto focused = Focused() ? ftxui::focus : ftxui::select;
-    auto style = nothing;
 
-    Element background = ComponentBase::Render();
-    background->ComputeRequirement();
-    size_ = background->requirement().min_y;
+    const auto items_cnt = items_->ChildCount();
+    item_desc_.resize(items_cnt);
+
+    // elements of the items are cheap to get, while measuring them is not,
+    // so only the items rendering a new element are measured
+    std::vector<Element> elems(items_cnt);
+    std::vector<int> heights(items_cnt);
+    int min_x = 0;
+    size_ = 0;
+    for (size_t i = 0; i < items_cnt; i++) {
+        elems[i] = items_->ChildAt(i)->Render();
+        auto &desc = item_desc_[i];
+        if (desc.elem_ != elems[i]) {
+            elems[i]->ComputeRequirement();
+            desc = { elems[i], elems[i]->requirement().min_x, elems[i]->requirement().min_y };
+        }
+        heights[i] = desc.height_;
+        min_x = std::max(min_x, desc.width_);
+        size_ += desc.height_;
+    }
 
-    return dbox({
-        std::move(background),
-        vbox({
-            text(L"") | size(HEIGHT, EQUAL, selected_),
-            text(L"") | style | focused
-        })
-    }) |
-    vscroll_indicator | yframe | yflex | reflect(box_);
+    return std::make_shared<VirtualListNode>(std::move(elems), std::move(heights),
+                                             min_x, top_, size_) |
+           focused | yflex | reflect(box_);
 }
 
-bool ScrollableComp::OnEvent(Event event) {
+bool VirtualListComp::OnEvent(Event event)
+{
     if (event.is_mouse() && box_.Contain(event.mouse().x, event.mouse().y))
         TakeFocus();
 
-    int selected_old = selected_;
+    const int dimy = box_.y_max - box_.y_min + 1;
+    int top_old = top_;
     if (event == Event::ArrowUp || event == Event::Character('k') ||
         (event.is_mouse() && event.mouse().button == Mouse::WheelUp)) {
-        selected_ -= 3;
+        top_ -= 3;
     }
 
     if ((event == Event::ArrowDown || event == Event::Character('j') ||
         (event.is_mouse() && event.mouse().button == Mouse::WheelDown))) {
-        selected_ += 3;
+        top_ += 3;
     }
 
     if (event == Event::PageDown)
-        selected_ += box_.y_max - box_.y_min;
+        top_ += dimy;
     if (event == Event::PageUp)
-        selected_ -= box_.y_max - box_.y_min;
+        top_ -= dimy;
     if (event == Event::Home)
-        selected_ = 0;
+        top_ = 0;
     if (event == Event::End)
-        selected_ = size_;
+        top_ = size_;
 
-    selected_ = std::max(0, std::min(size_ - 1, selected_));
-    return selected_old != selected_;
+    top_ = std::max(0, std::min(size_ - dimy, top_));
+    return top_old != top_;
 }
 
-static Component MakeScrollableComp(Component child)
+static Component MakeVirtualListComp(Component items)
 {
-    return Make<ScrollableComp>(child);
+    return Make<VirtualListComp>(items);
 }
 
 Element PCIRegsComponent::OnRender()
@@ -803,41 +1270,22 @@ Element PCIRegsComponent::OnRender()
 
             // In order to preserve opened register detailed info on device switch
             // we need to save both the split component itself (@split_comp_)
-            // and @vis_state_ vector. Visibility flag location within @vis_state_
-            // is determined during the component creation and expected
-            // not to be changed. (see GetCompMaybe for example)
-            if (cur_dev_) {
-                vis_state_map_.insert_or_assign(cur_dev_->dev_id_,
-                                                std::move(vis_state_));
-                comp_map_.insert_or_assign(cur_dev_->dev_id_,
-                                           split_comp_);
-            }
+            // and @vis_state_ store. Components refer to the flags within @vis_state_
+            // by handles obtained during the component creation.
+            // (see GetCompMaybe for example)
+            if (cur_dev_)
+                CacheComponent(cur_dev_->dev_id_);
         }
 
         cur_dev_ = newly_selected_dev_;
         DetachAllChildren();
 
-        vis_state_.clear();
-        // FIXME: Internal reallocation would break element visibility state tracking,
-        // so reserve some space in advance
-        vis_state_.reserve(interactive_elem_max_);
+        vis_state_ = std::make_shared<RegVisState>();
 
-        if (should_preserve_vis_state) {
-            // try to obtain previous highlighting state for the newly
-            // selected device
-            auto vis_state_iter = vis_state_map_.find(cur_dev_->dev_id_);
-            if (vis_state_iter != vis_state_map_.end())
-                vis_state_ = std::move(vis_state_iter->second);
-
-            // get the split component
-            auto comp_iter = comp_map_.find(cur_dev_->dev_id_);
-            if (comp_iter != comp_map_.end())
-                split_comp_ = comp_iter->second;
-            else
-                CreateComponent();
-        } else {
+        if (should_preserve_vis_state)
+            RestoreComponent(cur_dev_->dev_id_);
+        else
             CreateComponent();
-        }
 
         Add(split_comp_);
 
@@ -845,11 +1293,63 @@ Element PCIRegsComponent::OnRender()
     }
 }
 
+// Put current device component into the LRU cache. Evicted devices give
+// their components up, while their highlighting state is kept.
+void PCIRegsComponent::CacheComponent(uint64_t dev_id)
+{
+    const auto &tui_cfg = pciex_cfg.tui;
+    const size_t mem_estimate = vis_state_->size() * regs_comp_reg_mem_estimate;
+
+    comp_cache_lru_.push_front(dev_id);
+    comp_cache_.insert_or_assign(dev_id, RegsCompCacheEntry {
+        split_comp_, std::move(vis_state_), mem_estimate, comp_cache_lru_.begin()
+    });
+    comp_cache_mem_ += mem_estimate;
+    split_comp_ = nullptr;
+
+    while (!comp_cache_lru_.empty() &&
+           (comp_cache_.size() > tui_cfg.regs_comp_cache_size ||
+            comp_cache_mem_ > tui_cfg.regs_comp_cache_budget_kb * 1024ULL)) {
+        auto evicted_id = comp_cache_lru_.back();
+        auto node = comp_cache_.extract(evicted_id);
+        auto &entry = node.mapped();
+
+        comp_cache_mem_ -= entry.mem_estimate_;
+        comp_cache_lru_.pop_back();
+
+        if (entry.vis_state_->AnyHighlighted())
+            vis_state_map_.insert_or_assign(evicted_id, entry.vis_state_->Bits());
+
+        logger.log(Verbosity::INFO, "Regs component cache: evicted {:#x}, {} cached ({} KiB)",
+                   evicted_id, comp_cache_.size(), comp_cache_mem_ / 1024);
+    }
+}
+
+// Get the component of the newly selected device out of the cache,
+// or build it and restore the highlighting state if the device has been evicted
+void PCIRegsComponent::RestoreComponent(uint64_t dev_id)
+{
+    if (auto node = comp_cache_.extract(dev_id); !node.empty()) {
+        auto &entry = node.mapped();
+        comp_cache_mem_ -= entry.mem_estimate_;
+        comp_cache_lru_.erase(entry.lru_iter_);
+
+        split_comp_ = std::move(entry.comp_);
+        vis_state_ = std::move(entry.vis_state_);
+        return;
+    }
+
+    CreateComponent();
+
+    if (auto node = vis_state_map_.extract(dev_id); !node.empty())
+        vis_state_->Restore(node.mapped());
+}
+
 // Create type0/type1 configuration space header
 void PCIRegsComponent::AddCompatHeaderRegs()
 {
     Components upper_comps, lower_comps;
-    std::tie(upper_comps, lower_comps) = GetCompatHeaderRegsComponents(cur_dev_.get(), vis_state_);
+    std::tie(upper_comps, lower_comps) = GetCompatHeaderRegsComponents(cur_dev_, *vis_state_);
 
     for (const auto &el : upper_comps)
         upper_split_comp_->Add(el);
@@ -857,7 +1357,7 @@ void PCIRegsComponent::AddCompatHeaderRegs()
     for (const auto &el : lower_comps)
         lower_split_comp_->Add(el);
 
-    logger.log(Verbosity::INFO, "{} -> vis_state size {}", cur_dev_->dev_id_str_, vis_state_.size());
+    logger.log(Verbosity::INFO, "{} -> vis_state size {}", cur_dev_->DevIdStr(), vis_state_->size());
 }
 
 void PCIRegsComponent::AddCapabilities()
@@ -865,28 +1365,28 @@ void PCIRegsComponent::AddCapabilities()
     bool compat_delim_present {false}, ext_delim_present {false};
     Components upper_comps, lower_comps;
 
-    for (const auto &cap : cur_dev_->caps_) {
-        auto type = std::get<0>(cap);
-        auto id   = std::get<1>(cap);
+    for (const auto &cap : cur_dev_->GetCaps()) {
+        auto type = cap.type();
+        auto id   = cap.id();
 
         if (type == pci::CapType::compat) {
             if (!compat_delim_present) {
                 upper_split_comp_->Add(CapsDelimComp(pci::CapType::compat,
-                                                     cur_dev_->compat_caps_num_));
+                                                     cur_dev_->GetCapsNum(pci::CapType::compat)));
                 compat_delim_present = true;
             }
             CompatCapID cap_id {id};
-            std::tie(upper_comps, lower_comps) = GetCompatCapComponents(cur_dev_.get(), cap_id,
-                                                                        cap, vis_state_);
+            std::tie(upper_comps, lower_comps) = GetCompatCapComponents(cur_dev_, cap_id,
+                                                                        cap, *vis_state_);
         } else {
             if (!ext_delim_present) {
                 upper_split_comp_->Add(CapsDelimComp(pci::CapType::extended,
-                                                     cur_dev_->extended_caps_num_));
+                                                     cur_dev_->GetCapsNum(pci::CapType::extended)));
                 ext_delim_present = true;
             }
             ExtCapID cap_id {id};
-            std::tie(upper_comps, lower_comps) = GetExtendedCapComponents(cur_dev_.get(), cap_id,
-                                                                          cap, vis_state_);
+            std::tie(upper_comps, lower_comps) = GetExtendedCapComponents(cur_dev_, cap_id,
+                                                                          cap, *vis_state_);
         }
 
         for (const auto &el : upper_comps)
@@ -910,7 +1410,7 @@ void PCIRegsComponent::CreateComponent()
 
 void PCIRegsComponent::FinalizeComponent()
 {
-    auto lower_comp = MakeScrollableComp(lower_split_comp_);
+    auto lower_comp = MakeVirtualListComp(lower_split_comp_);
 
     auto upper_comp = upper_split_comp_;
     auto upper_comp_renderer = Renderer(upper_comp, [=] {
@@ -946,15 +1446,25 @@ void PCIRegsComponent::FinalizeComponent()
 
 }
 
+// Check if a device, which is not currently selected, has any regs highlighted
+bool PCIRegsComponent::DevHaveRegsHighlighted(uint64_t dev_id) const
+{
+    if (!pciex_cfg.tui.keep_dev_selected_regs)
+        return false;
+
+    if (auto it = comp_cache_.find(dev_id); it != comp_cache_.end())
+        return it->second.vis_state_->AnyHighlighted();
+
+    return vis_state_map_.contains(dev_id);
+}
+
 // Check @vis_state_ to see if any regs have their detailed info displayed
 bool PCIRegsComponent::CurDevHaveRegsHighlighted()
 {
     if (!pciex_cfg.tui.keep_dev_selected_regs)
         return false;
 
-    // This should works fast enough considering the size of @vis_state_.
-    auto res = std::accumulate(vis_state_.begin(), vis_state_.end(), 0);
-    return res > 0;
+    return vis_state_ != nullptr && vis_state_->AnyHighlighted();
 }
 
 Element BorderedHoverComp::OnRender()
@@ -1055,6 +1565,8 @@ static Element GetHelpElem()
     R"(                                (device tree pane only)       )",
     R"(  left click / enter          - show/hide detailed info       )",
     R"(                                (device regs/caps pane only)  )",
+    R"(  space / enter - collapse/expand selected bridge subtree     )",
+    R"(                  or SR-IOV VFs (device tree pane only)       )",
     R"( Other hotkeys:                                               )",
     R"(      c/v - device tree pane compact/verbose                  )",
     R"(            drawing mode switch                               )",
@@ -1084,7 +1596,7 @@ Component GetHelpScreenComp()
 
     // XXX: Seems like @Modal component rendering doesn't
     // clear background color explicitly, so it needs to be set here
-    auto scrollable_help_comp = MakeScrollableComp(help_comp);
+    auto scrollable_help_comp = MakeVirtualListComp(Container::Vertical({help_comp}));
     return Renderer(scrollable_help_comp, [=] {
         return vbox({
             scrollable_help_comp->Render(),
@@ -1125,18 +1637,39 @@ ScreenCompCtx::ScreenCompCtx(const pci::PCITopologyCtx &topo_ctx) :
 
 Component
 ScreenCompCtx::Create()
+{
+    return CreateComps(false);
+}
+
+Component
+ScreenCompCtx::CreateLoading()
+{
+    return CreateComps(true);
+}
+
+void ScreenCompCtx::OnLoadProgress(std::span<pci::PciDevBase * const> devs)
+{
+    topo_canvas_->AddLoadedDevices(devs);
+}
+
+void ScreenCompCtx::OnTopologyLoaded()
+{
+    topo_canvas_->OnTopologyLoaded();
+}
+
+Component
+ScreenCompCtx::CreateComps(bool loading)
 {
     // right split pane
     pci_regs_comp_ = std::make_shared<PCIRegsComponent>();
 
     auto draw_mode = pciex_cfg.tui.dt_dflt_draw_verbose ?
                      ElemReprMode::Verbose : ElemReprMode::Compact;
-    auto [width, height] = GetCanvasSizeEstimate(topo_ctx_, draw_mode);
     // left canvas pane
-    topo_canvas_ = std::make_shared<PCITopoUIComp>(width, height,
-                                                  topo_ctx_,
+    topo_canvas_ = std::make_shared<PCITopoUIComp>(topo_ctx_,
                                                   pci_regs_comp_,
-                                                  draw_mode);
+                                                  draw_mode,
+                                                  loading);
     topo_canvas_comp_ = MakeBorderedHoverComp(topo_canvas_);
 
 
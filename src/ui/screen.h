@@ -7,8 +7,16 @@
 #include <ftxui/component/component.hpp>
 #include <ftxui/component/event.hpp>
 
+#include <array>
+#include <list>
+#include <map>
+#include <optional>
+#include <span>
+#include <unordered_map>
+
 #include "pci_dev.h"
 #include "pci_topo.h"
+#include "reg_vis_state.h"
 
 namespace ui {
 
@@ -31,8 +39,10 @@ struct CanvasVisibleArea
 };
 
 const auto NoStyle = [](ftxui::Pixel &){};
-//                    X         Y        len      height
-typedef std::tuple<uint16_t, uint16_t, uint16_t, uint16_t> ShapeDesc;
+//                 X    Y    len  height
+typedef std::tuple<int, int, int, int> ShapeDesc;
+typedef std::pair<int, int> PointDesc;
+typedef std::pair<PointDesc, PointDesc> LineDesc;
 
 // XXX: values below were obtained experimentally
 // Length of the box to fully fit text
@@ -44,12 +54,48 @@ constexpr uint16_t tbox_height = 6;
 constexpr uint16_t tbox_txt_xoff = 4;
 constexpr uint16_t tbox_txt_yoff = 4;
 
-class ScrollableCanvas : public ftxui::Canvas
+// Fixed-size piece of the topology canvas.
+// Elements are drawn using logical canvas coordinates, which are translated
+// by the tile origin, everything outside of the tile is clipped.
+class CanvasTile : public ftxui::Canvas
 {
 public:
-    ScrollableCanvas() = delete;
-    ScrollableCanvas(int width, int height)
-        : ftxui::Canvas(width, height) {}
+    CanvasTile() = delete;
+    CanvasTile(int x_org, int y_org, int width, int height)
+        : ftxui::Canvas(width, height), x_org_(x_org), y_org_(y_org) {}
+
+    // Check if the box [x, x + len] x [y, y + height] intersects the tile
+    bool Intersects(ShapeDesc desc) const noexcept
+    {
+        auto [x, y, len, height] = desc;
+        return x + len >= x_org_ && x < x_org_ + width() &&
+               y + height >= y_org_ && y < y_org_ + this->height();
+    }
+
+    template <typename... Args>
+    void DrawPointLine(int x1, int y1, int x2, int y2, Args &&...args)
+    {
+        // Lines on the canvas are axis-aligned, so they could be cheaply clipped
+        // to avoid walking over the points outside of the tile
+        if (x1 == x2) {
+            if (x1 < x_org_ || x1 >= x_org_ + width() ||
+                !ClipSpan(y1, y2, y_org_, height()))
+                return;
+        } else if (y1 == y2) {
+            if (y1 < y_org_ || y1 >= y_org_ + height() ||
+                !ClipSpan(x1, x2, x_org_, width()))
+                return;
+        }
+
+        ftxui::Canvas::DrawPointLine(x1 - x_org_, y1 - y_org_, x2 - x_org_, y2 - y_org_,
+                                     std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    void DrawText(int x, int y, const std::string &text, Args &&...args)
+    {
+        ftxui::Canvas::DrawText(x - x_org_, y - y_org_, text, std::forward<Args>(args)...);
+    }
 
     // draw a simple box
     void DrawBoxLine(ShapeDesc desc, const ftxui::Color &color);
@@ -60,15 +106,75 @@ public:
     // FIXME: text is expected to be single line for now
     // @pos {x, y}: x is expected to be mulitple of 2,
     //              y is expected to be multiple of 4
-    void DrawTextBox(std::pair<uint16_t, uint16_t> pos, std::string text,
+    void DrawTextBox(PointDesc pos, std::string text,
                      const ftxui::Canvas::Stylizer &box_style = NoStyle,
                      const ftxui::Canvas::Stylizer &text_style = NoStyle);
 
-    int x_off() const { return area_.off_x_; }
-    int y_off() const { return area_.off_y_; }
+private:
+    int x_org_;
+    int y_org_;
+
+    // Clip [a, b] span to [org, org + len), false is returned if it's outside
+    static bool ClipSpan(int &a, int &b, const int org, const int len) noexcept
+    {
+        if (a > b)
+            std::swap(a, b);
+        a = std::max(a, org);
+        b = std::min(b, org + len - 1);
+        return a <= b;
+    }
+};
+
+struct CanvasElementBase;
+struct CanvasElemBox;
+struct TopoLayout;
+using CanvasElems = std::vector<std::shared_ptr<CanvasElementBase>>;
+
+// Tile dimensions in cells (one cell is 2 x 4 dots)
+constexpr int canvas_tile_cols = 128;
+constexpr int canvas_tile_rows = 32;
+// Max number of rasterised tiles kept in the cache
+constexpr size_t canvas_tile_cache_size = 64;
+
+// Virtualised canvas of the topology elements.
+// Instead of rasterising all the elements into a canvas of the full size,
+// only tiles intersecting the visible area are rasterised on demand.
+// They are kept in a bounded LRU cache, so memory usage doesn't depend
+// on the topology size.
+class ScrollableCanvas
+{
+public:
+    ScrollableCanvas() = default;
+    ScrollableCanvas(int width, int height) : width_(width), height_(height) {}
+
+    // Canvas dimensions in dots
+    int width() const { return width_; }
+    int height() const { return height_; }
+
+    // Set elements to be drawn on the canvas using @layout geometry,
+    // drops all rasterised tiles. Canvas is resized to the exact extent of @layout.
+    // NOTE: @elems and @layout must outlive the canvas
+    void SetElements(const CanvasElems &elems, const TopoLayout &layout);
+
+    // Grow or shrink the canvas, memory usage doesn't depend on its size
+    void Resize(const int width, const int height);
+
+    // Redraw the box outline on already rasterised tiles, e.g. on selection change.
+    // The outline is the only part of the box depending on its state, so tiles
+    // not crossed by it are left intact. Tiles which are not cached would pick
+    // the element state up once rasterised.
+    void RedrawOutline(CanvasElemBox &elem);
+
+    // Get tile with [tile_x, tile_y] coordinates (in tiles), rasterise it if needed
+    const CanvasTile &GetTile(const int tile_x, const int tile_y) const;
+
+    // Copy the visible part of the canvas into @box of the @screen.
+    // The last composed viewport is cached, so only the rows damaged by Redraw*()
+    // calls or exposed by scrolling are composed out of the tiles again.
+    void Blit(ftxui::Screen &screen, const ftxui::Box &box) const;
 
     // Set max [x, y] values in pixels
-    void VisibleAreaSetMax(const uint16_t x_max, const uint16_t y_max) noexcept
+    void VisibleAreaSetMax(const int x_max, const int y_max) noexcept
     {
         area_.x_max_ = x_max;
         area_.y_max_ = y_max;
@@ -76,7 +182,40 @@ public:
     CanvasVisibleArea *GetVisibleAreaDesc() { return &area_; }
 
 private:
-    CanvasVisibleArea area_;
+    using TileLRU = std::list<std::pair<uint64_t, CanvasTile>>;
+
+    // Viewport cells composed by the last Blit()
+    struct Frame
+    {
+        bool                      valid_ {false};
+        int                       x_off_ {0};
+        int                       y_off_ {0};
+        int                       dimx_ {0};
+        int                       dimy_ {0};
+        std::vector<ftxui::Pixel> pixels_;
+        // rows to be composed again during the current Blit()
+        std::vector<uint8_t>      stale_rows_;
+    };
+
+    // Mark canvas rows covered by @rect (in dots) as damaged
+    void Damage(ShapeDesc rect);
+    void ComposeRow(const int row) const;
+
+    int                                 width_ {0};
+    int                                 height_ {0};
+    CanvasVisibleArea                   area_;
+    const CanvasElems                  *elems_ {nullptr};
+    const TopoLayout                   *layout_ {nullptr};
+    // indices of the elements intersecting every row of tiles
+    std::vector<std::vector<uint32_t>>  tile_rows_;
+
+    // Most recently used tiles are at the front
+    mutable TileLRU                                         tiles_lru_;
+    mutable std::unordered_map<uint64_t, TileLRU::iterator> tiles_;
+
+    mutable Frame                       frame_;
+    // canvas rows (in cells) damaged since the last Blit()
+    mutable std::vector<int>            damaged_rows_;
 };
 
 enum class ElemReprMode
@@ -84,70 +223,134 @@ enum class ElemReprMode
     Compact,
     Verbose
 };
+constexpr size_t elem_repr_modes_cnt = 2;
+
+constexpr uint16_t sym_height = 4;
+constexpr uint16_t sym_width = 2;
+
+// Geometry of the topology elements on canvas in a given representation mode.
+// Computed once by the layout pass and stored in flat arrays, elements only
+// refer to it by indices, which are the same for all modes.
+struct TopoLayout
+{
+    ElemReprMode           mode_ {ElemReprMode::Compact};
+    // boxes of all the box elements, see CanvasElemBox::box_idx_
+    std::vector<ShapeDesc> boxes_;
+    // lines of all the connectors, every connector owns a contiguous range
+    std::vector<LineDesc>  lines_;
+    // rightmost and bottommost dots occupied by the elements
+    int                    x_max_ {0};
+    int                    y_max_ {0};
+};
 
 struct CanvasElementBase
 {
-    virtual void Draw(ScrollableCanvas &canvas) = 0;
+    virtual void Draw(CanvasTile &canvas, const TopoLayout &layout) = 0;
+    // Bounding box of everything the element draws
+    virtual ShapeDesc GetBounds(const TopoLayout &layout) const noexcept = 0;
 };
 
-typedef std::pair<uint16_t, uint16_t> PointDesc;
-constexpr uint16_t sym_height = 4;
-constexpr uint16_t sym_width = 2;
+// Element drawn as a box. Its position is determined by the layout pass
+// out of the tree depth and the space taken by preceding elements.
+struct CanvasElemBox : public CanvasElementBase
+{
+    uint32_t box_idx_ {0};
+    // depth within the topology tree, determines horizontal offset
+    uint16_t depth_ {0};
+
+    // Box [length, height] in dots
+    virtual PointDesc GetSize(ElemReprMode mode) const noexcept = 0;
+    // Vertical space taken by the element
+    virtual uint16_t GetAdvance(ElemReprMode mode) const noexcept = 0;
+
+    ShapeDesc GetBounds(const TopoLayout &layout) const noexcept override
+    {
+        return layout.boxes_[box_idx_];
+    }
+    // Draw only the box outline with the style corresponding to the element state
+    virtual void DrawOutline([[maybe_unused]] CanvasTile &canvas,
+                             [[maybe_unused]] const TopoLayout &layout) {}
+    // Connection points of the lines coming to the children and from the parent
+    static PointDesc GetConnPosParent(ShapeDesc box) noexcept;
+    static PointDesc GetConnPosChild(ShapeDesc box) noexcept;
+};
 
 // Visually connects parent to child elements on canvas
 struct CanvasElemConnector : public CanvasElementBase
 {
-    std::vector<std::pair<PointDesc, PointDesc>> lines_;
+    uint32_t              parent_box_;
+    std::vector<uint32_t> child_boxes_;
+    // first line within TopoLayout::lines_
+    uint32_t              first_line_ {0};
+
+    explicit CanvasElemConnector(uint32_t parent_box) : parent_box_(parent_box) {}
 
-    void AddLine(std::pair<PointDesc, PointDesc> line_desc);
-    void Draw(ScrollableCanvas &canvas) override;
+    size_t LinesCnt() const noexcept { return child_boxes_.size() + 1; }
+    // Compute connector lines out of parent/children boxes
+    void Layout(TopoLayout &layout) const;
+
+    void Draw(CanvasTile &canvas, const TopoLayout &layout) override;
+    ShapeDesc GetBounds(const TopoLayout &layout) const noexcept override;
 };
 
 // Descriptor of PCI device on canvas
-struct CanvasElemPCIDev : public CanvasElementBase
+struct CanvasElemPCIDev : public CanvasElemBox
 {
-    std::shared_ptr<pci::PciDevBase> dev_;
+    pci::PciDevBase                 *dev_;
+    // text for all the modes, compact mode uses only the first line
     std::vector<std::string>         text_data_;
-    ShapeDesc                        points_;
     bool                             selected_ {false};
 
     bool                             has_highlighted_regs_ {false};
+    // collapse/expand mark of the devices with a subtree or SR-IOV VFs,
+    // drawn right after the first text line
+    std::string                      fold_mark_;
 
     CanvasElemPCIDev() = delete;
-    CanvasElemPCIDev(std::shared_ptr<pci::PciDevBase> dev, ElemReprMode repr_mode,
-                     uint16_t x, uint16_t y);
+    explicit CanvasElemPCIDev(pci::PciDevBase *dev);
+
+    size_t GetTextLines(ElemReprMode mode) const noexcept
+    {
+        return mode == ElemReprMode::Verbose ? text_data_.size() : 1;
+    }
+
+    // @hidden_cnt is the number of devices hidden by collapsing
+    void SetFoldState(bool collapsible, bool collapsed, size_t hidden_cnt);
 
-    uint16_t GetHeight() noexcept;
-    PointDesc GetConnPosParent() noexcept;
-    PointDesc GetConnPosChild() noexcept;
-    ShapeDesc GetShapeDesc() noexcept;
+    PointDesc GetSize(ElemReprMode mode) const noexcept override;
+    uint16_t GetAdvance(ElemReprMode mode) const noexcept override;
 
-    void Draw(ScrollableCanvas &canvas) override;
+    void Draw(CanvasTile &canvas, const TopoLayout &layout) override;
+    void DrawOutline(CanvasTile &canvas, const TopoLayout &layout) override;
 };
 
-struct CanvasElemBus : public CanvasElementBase
+struct CanvasElemBus : public CanvasElemBox
 {
     std::string bus_id_str_;
-    ShapeDesc   points_;
 
     CanvasElemBus() = delete;
-    CanvasElemBus(const pci::PCIBus &bus, uint16_t x, uint16_t y);
+    explicit CanvasElemBus(const pci::PCIBus &bus);
 
-    PointDesc GetConnPos() noexcept;
+    PointDesc GetSize(ElemReprMode mode) const noexcept override;
+    uint16_t GetAdvance(ElemReprMode mode) const noexcept override;
 
-    void Draw(ScrollableCanvas &canvas) override;
+    void Draw(CanvasTile &canvas, const TopoLayout &layout) override;
 };
 
-struct CanvasElemMode : public CanvasElementBase
+struct CanvasElemMode : public CanvasElemBox
 {
     bool        is_live_;
     std::string mode_text_;
-    ShapeDesc   points_;
 
     CanvasElemMode() = delete;
-    CanvasElemMode(bool is_live, uint16_t x, uint16_t y);
+    // @loaded_cnt is the number of devices loaded so far, if the topology
+    // is still being populated
+    CanvasElemMode(bool is_live, std::optional<size_t> loaded_cnt);
 
-    void Draw(ScrollableCanvas &canvas) override;
+    PointDesc GetSize(ElemReprMode mode) const noexcept override;
+    uint16_t GetAdvance(ElemReprMode mode) const noexcept override;
+
+    void Draw(CanvasTile &canvas, const TopoLayout &layout) override;
 };
 
 class CanvasScrollNodeBase : public ftxui::Node
@@ -156,48 +359,49 @@ public:
     CanvasScrollNodeBase() = default;
     void Render(ftxui::Screen &screen) override
     {
-        const auto &c = canvas();
-
-        const int y_max = std::min(c.height() / 4, box_.y_max - box_.y_min + 1);
-        const int x_max = std::min(c.width() / 2, box_.x_max - box_.x_min + 1);
-
-        for (int y = 0; y < y_max; ++y) {
-          for (int x = 0; x < x_max; ++x) {
-            screen.PixelAt(box_.x_min + x, box_.y_min + y) =
-                           c.GetPixel(x + c.x_off(), y + c.y_off());
-          }
-        }
+        canvas().Blit(screen, box_);
     }
     virtual const ScrollableCanvas &canvas() = 0;
 };
 
 // mouse tracking stuff
-typedef std::pair<uint16_t, uint16_t> BlockSnglDimDesc;
-
-inline auto bd_comp = [](const BlockSnglDimDesc &bd1, const BlockSnglDimDesc &bd2) {
-                        return bd1.first < bd2.first; };
-typedef std::map<BlockSnglDimDesc, std::shared_ptr<CanvasElemPCIDev>,
-                 decltype(bd_comp)> CanvasSnglDimBlockMap;
-typedef CanvasSnglDimBlockMap::iterator BlockMapIter;
 
+// Flat index of the device boxes used for hit-testing and navigation.
+// Boxes never overlap vertically, so they are kept sorted by Y as a set of
+// parallel arrays, which are searched without chasing any pointers.
 struct CanvasDevBlockMap
 {
-    CanvasSnglDimBlockMap             blocks_y_dim_;
-    std::shared_ptr<CanvasElemPCIDev> selected_dev_ {nullptr};
-    // currently selected device map iterator
-    BlockMapIter                      selected_dev_iter_;
-
-    std::vector<bool> regs_highlighted_elems_;
-
-    CanvasDevBlockMap() : selected_dev_iter_(blocks_y_dim_.end()) {}
-
-    bool Insert(std::shared_ptr<CanvasElemPCIDev> dev);
-    void SelectDeviceByPos(const uint16_t mouse_x, const uint16_t mouse_y,
-                           ScrollableCanvas &canvas, bool highlighted_regs);
-    void SelectNextPrevDevice(ScrollableCanvas &canvas, bool highlighted_regs,
-                              bool select_next);
-    void ReapplyHighlight();
-    void Reset();
+    static constexpr size_t npos = SIZE_MAX;
+
+    std::vector<int>                y_;
+    std::vector<int>                height_;
+    std::vector<int>                x_;
+    std::vector<int>                len_;
+    std::vector<CanvasElemPCIDev *>  devs_;
+    // index of currently selected device
+    size_t                          selected_ {npos};
+    // geometry the blocks have been inserted with
+    const TopoLayout               *layout_ {nullptr};
+
+    // Devices are expected to be inserted in the layout order
+    bool Insert(CanvasElemPCIDev *dev);
+    // Index of the last block starting at or above @y, npos if there is none
+    size_t FindByY(const int y) const noexcept;
+
+    CanvasElemPCIDev *Selected() const noexcept
+    {
+        return selected_ == npos ? nullptr : devs_[selected_];
+    }
+
+    // Selectors return previously selected device if selection has changed,
+    // nullptr otherwise. Changed elements are expected to be redrawn by the caller.
+    CanvasElemPCIDev *SelectDeviceByPos(const int mouse_x, const int mouse_y,
+                                        bool highlighted_regs);
+    CanvasElemPCIDev *SelectNextPrevDevice(bool highlighted_regs, bool select_next);
+    void SyncSelection(const CanvasElemPCIDev &dev);
+
+private:
+    CanvasElemPCIDev *Select(size_t idx, bool highlighted_regs);
 };
 
 constexpr uint16_t child_elem_xoff = 16;
@@ -213,17 +417,22 @@ class PCITopoUIComp : public ftxui::ComponentBase
 {
 public:
     PCITopoUIComp() = delete;
-    PCITopoUIComp(int width, int height, const pci::PCITopologyCtx &ctx,
+    // If @loading is set, the topology is still being populated and must not be
+    // accessed, devices are passed via AddLoadedDevices() instead
+    PCITopoUIComp(const pci::PCITopologyCtx &ctx,
                   std::shared_ptr<PCIRegsComponent> rcomp,
-                  ElemReprMode draw_mode) :
+                  ElemReprMode draw_mode, bool loading) :
         ftxui::ComponentBase(),
         topo_ctx_(ctx),
         regs_comp_(rcomp),
         current_drawing_mode_(draw_mode),
-        block_map_(),
-        canvas_(width, height)
+        loading_(loading)
     {
-        AddTopologyElements();
+        if (!loading_)
+            InitCollapsedState();
+        DevElemsByDev no_prev_elems;
+        BuildTopologyElements(no_prev_elems);
+        InitModes();
     }
 
     ftxui::Element OnRender() override final;
@@ -231,32 +440,74 @@ public:
     bool OnEvent(ftxui::Event event) override final;
     bool Focusable() const final { return true; }
 
+    // Add devices decoded since the previous call, the topology is still loading
+    void AddLoadedDevices(std::span<pci::PciDevBase * const> devs);
+    // Replace the devices loaded so far with the topology tree
+    void OnTopologyLoaded();
+
 private:
-    std::vector<std::shared_ptr<CanvasElementBase>> canvas_elems_;
-    int                                             max_width_ {0};
+    using DevElemsByDev = std::unordered_map<const pci::PciDevBase *,
+                                             std::shared_ptr<CanvasElemPCIDev>>;
+
+    // State depending on the elements representation mode
+    struct ModeCtx
+    {
+        TopoLayout        layout_;
+        CanvasDevBlockMap block_map_;
+        ScrollableCanvas  canvas_;
+    };
+
+    CanvasElems                                     canvas_elems_;
+    // box elements in layout order, indexed by CanvasElemBox::box_idx_
+    std::vector<CanvasElemBox *>                    box_elems_;
+    std::vector<std::shared_ptr<CanvasElemPCIDev>>  dev_elems_;
+    std::vector<CanvasElemConnector *>              connectors_;
+    size_t                                          lines_cnt_ {0};
+    // Collapsed state of the bridges subtrees and SR-IOV PFs VF groups,
+    // indexed by device topology index. No elements are constructed
+    // for the devices within collapsed subtrees.
+    std::vector<uint8_t>                            collapsed_;
+    // While the topology is being populated, its tree is unknown, so the devices
+    // loaded so far are shown as flat lists grouped by (domain, bus)
+    std::map<uint32_t, pci::PCIBus>                 loading_buses_;
+    size_t                                          loaded_cnt_ {0};
     const pci::PCITopologyCtx                       &topo_ctx_;
     std::shared_ptr<PCIRegsComponent>               regs_comp_;
     ElemReprMode                                    current_drawing_mode_;
-    CanvasDevBlockMap                               block_map_;
+    bool                                            loading_;
+    std::array<ModeCtx, elem_repr_modes_cnt>        modes_;
     bool                                            hovered_ { false };
     ftxui::Box                                      box_;
-    ScrollableCanvas                                canvas_;
-
-    void DrawElements() noexcept;
-    void AddTopologyElements();
-    std::pair<PointDesc, PointDesc>
-    AddDevice(std::shared_ptr<pci::PciDevBase> dev, uint16_t x, uint16_t *y);
-    PointDesc
-    AddRootBus(const pci::PCIBus &bus, uint16_t *x, uint16_t *y);
-    void AddBusDevices(const pci::PCIBus &current_bus,
-                       const std::map<uint16_t, pci::PCIBus> &bus_map,
-                       PointDesc parent_conn_pos,
-                       uint16_t x_off, uint16_t *y_off);
+
+    ModeCtx &CurMode() noexcept
+    {
+        return modes_[static_cast<size_t>(current_drawing_mode_)];
+    }
+
+    void InitCollapsedState();
+    // @prev_elems are the elements to be reused, see RebuildElements()
+    void BuildTopologyElements(DevElemsByDev &prev_elems);
+    void AddBoxElem(std::shared_ptr<CanvasElemBox> elem, uint16_t depth);
+    size_t GetSubtreeSize(const pci::PciDevBase *dev) const noexcept;
+    uint32_t AddDevElem(pci::PciDevBase *dev, uint16_t depth, DevElemsByDev &prev_elems);
+    void AddConnector(std::shared_ptr<CanvasElemConnector> connector);
+    void AddBusDevices(const pci::PCIBus &current_bus, uint32_t parent_box,
+                       uint16_t depth, DevElemsByDev &prev_elems);
+    void AddDevNode(pci::PciDevBase *dev, uint16_t depth,
+                    CanvasElemConnector &connector, DevElemsByDev &prev_elems);
+    void AddDevChildren(pci::PciDevBase *dev, uint32_t dev_box, uint16_t depth,
+                        DevElemsByDev &prev_elems);
+    void LayoutElements(ElemReprMode mode, TopoLayout &layout) const;
+    void LayoutModes();
+    void InitModes();
+    void SelectFirstDev();
+    void RebuildElements();
+    void ToggleCollapsed();
+    void UpdateSelection(CanvasElemPCIDev *prev_selected);
     void SwitchDrawingMode(ElemReprMode);
 };
 
-std::pair<uint16_t, uint16_t>
-GetCanvasSizeEstimate(const pci::PCITopologyCtx &ctx, ElemReprMode mode) noexcept;
+std::pair<int, int> GetCanvasSize(const TopoLayout &layout) noexcept;
 
 // TODO: It seems not to be easy to add scrolling to the component made of a bunch
 // of static DOM elements, e.g:
@@ -270,26 +521,50 @@ GetCanvasSizeEstimate(const pci::PCITopologyCtx &ctx, ElemReprMode mode) noexcep
 //           ftxui::hscroll_indicator | ftxui::frame;
 // });
 //
-// This component seems to solve this problem, but at the cost of losing interactivity.
+// ScrollableComp from git-tui used to solve this problem, but at the cost of losing
+// interactivity. It also laid out the whole tree on every frame to figure out
+// its size, so it's replaced by the virtual list below.
 // See: https://github.com/ArthurSonzogni/FTXUI/discussions/657
 // https://github.com/ArthurSonzogni/git-tui/blob/master/src/scroller.cpp
-class ScrollableComp : public ftxui::ComponentBase
+
+// Number of items rendered above and below the visible window
+constexpr int virt_list_overscan = 2;
+
+// Scrollable list of (non-interactive) components.
+// Only the items intersecting the visible window plus @virt_list_overscan items
+// around it get into the document. Item heights are measured once and cached
+// along with the element they've been measured for, so an item is measured
+// again only when it renders a different element, e.g. on visibility toggle.
+class VirtualListComp : public ftxui::ComponentBase
 {
 public:
-    ScrollableComp(ftxui::Component child) { Add(child); }
+    explicit VirtualListComp(ftxui::Component items) : items_(items) { Add(items); }
 
 private:
     ftxui::Element OnRender() override final;
     bool OnEvent(ftxui::Event event) final;
     bool Focusable() const final { return true;  }
 
-    int selected_ {0};
-    int     size_ {0};
-    ftxui::Box box_;
+    struct ItemDesc
+    {
+        ftxui::Element elem_;
+        int            width_ {0};
+        int            height_ {0};
+    };
+
+    ftxui::Component      items_;
+    std::vector<ItemDesc> item_desc_;
+    // first visible line
+    int                   top_ {0};
+    // total height of all the items
+    int                   size_ {0};
+    ftxui::Box            box_;
 };
 
 
-using RegHighlightState = std::vector<uint8_t>;
+// Rough estimate of the memory taken by the components of a single register:
+// the button, the detailed info window and their element trees
+constexpr size_t regs_comp_reg_mem_estimate = 2048;
 
 // Holds resizable split component representing currently selected device.
 // ┌───────────────────────────┐
@@ -299,17 +574,31 @@ using RegHighlightState = std::vector<uint8_t>;
 // └───────────────────────────┘
 struct PCIRegsComponent : ftxui::ComponentBase
 {
-    std::shared_ptr<pci::PciDevBase> newly_selected_dev_;
-    std::shared_ptr<pci::PciDevBase> cur_dev_;
+    pci::PciDevBase                 *newly_selected_dev_ {nullptr};
+    pci::PciDevBase                 *cur_dev_ {nullptr};
     ftxui::Component                 upper_split_comp_;
     ftxui::Component                 lower_split_comp_;
     ftxui::Component                 split_comp_;
-    RegHighlightState                vis_state_;
+    std::shared_ptr<RegVisState>     vis_state_;
     int                              split_off_ {40};
-    uint32_t                         interactive_elem_max_ {1024};
 
-    std::unordered_map<uint64_t, RegHighlightState> vis_state_map_;
-    std::unordered_map<uint64_t, ftxui::Component> comp_map_;
+    // Recently selected devices components along with the highlighting state
+    // they refer to, see @pciex_cfg.tui.regs_comp_cache_size
+    struct RegsCompCacheEntry
+    {
+        ftxui::Component                    comp_;
+        std::shared_ptr<RegVisState>        vis_state_;
+        size_t                              mem_estimate_;
+        std::list<uint64_t>::iterator       lru_iter_;
+    };
+    std::unordered_map<uint64_t, RegsCompCacheEntry> comp_cache_;
+    // Most recently used devices are at the front
+    std::list<uint64_t>                              comp_cache_lru_;
+    size_t                                           comp_cache_mem_ {0};
+
+    // Highlighting state of the devices evicted from @comp_cache_.
+    // Only the devices which have any registers highlighted are kept.
+    std::unordered_map<uint64_t, std::vector<uint64_t>> vis_state_map_;
 
     ftxui::Element OnRender() override;
     bool Focusable() const final { return true; }
@@ -318,12 +607,19 @@ struct PCIRegsComponent : ftxui::ComponentBase
 
     void CreateComponent();
     void FinalizeComponent();
+    void CacheComponent(uint64_t dev_id);
+    void RestoreComponent(uint64_t dev_id);
     void AddCompatHeaderRegs();
     void AddCapabilities();
 
     bool CurDevHaveRegsHighlighted();
-    void UpdateSelectedDev(std::shared_ptr<pci::PciDevBase> selected_dev) { newly_selected_dev_ = selected_dev; }
-    void ResetRegsVisibilityState() { std::ranges::fill(vis_state_, 0); }
+    bool DevHaveRegsHighlighted(uint64_t dev_id) const;
+    void UpdateSelectedDev(pci::PciDevBase *selected_dev) { newly_selected_dev_ = selected_dev; }
+    void ResetRegsVisibilityState()
+    {
+        if (vis_state_)
+            vis_state_->Reset();
+    }
 };
 
 // Wrapper to draw border around component on hover/select.
@@ -358,7 +654,18 @@ public:
   ftxui::Component
   Create();
 
+  // Create main screen components while the topology is being populated.
+  // Topology pane shows the devices loaded so far until OnTopologyLoaded().
+  // Both progress and completion notifications must come from the UI thread.
+  ftxui::Component
+  CreateLoading();
+  void OnLoadProgress(std::span<pci::PciDevBase * const> devs);
+  void OnTopologyLoaded();
+
 private:
+  ftxui::Component
+  CreateComps(bool loading);
+
   const pci::PCITopologyCtx         &topo_ctx_;
   std::shared_ptr<PCITopoUIComp>    topo_canvas_;
   ftxui::Component                  topo_canvas_comp_;
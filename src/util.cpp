@@ -4,7 +4,13 @@
 #include "util.h"
 #include "log.h"
 
+#include <charconv>
+#include <cstring>
 #include <fstream>
+#include <memory>
+
+#include <fcntl.h>
+#include <unistd.h>
 
 extern Logger logger;
 
@@ -23,18 +29,58 @@ void vm::VmallocStats::DumpStats()
     }
 }
 
-// Find VA space range(s) the physical address space [pa_start, pa_end]
+void vm::VmallocStats::BuildIndex()
+{
+    std::ranges::sort(vm_entries_, [](const auto &a, const auto &b) {
+                      return a.pa_ < b.pa_; });
+
+    const auto n = static_cast<int64_t>(vm_entries_.size());
+    max_pa_end_.resize(n);
+    max_lvl_ = -1;
+    if (n == 0)
+        return;
+
+    // leaves (level 0 nodes)
+    int64_t  last_i = 0;
+    uint64_t last_max = 0;
+    for (int64_t i = 0; i < n; i += 2) {
+        last_i = i;
+        last_max = max_pa_end_[i] = PaEnd(vm_entries_[i]);
+    }
+
+    // Annotate inner nodes level by level. The rightmost subtree might be
+    // incomplete, so the right child of a node could be out of range: in this
+    // case max PA end of the last existing node at the lower level is used.
+    int lvl;
+    for (lvl = 1; (int64_t{1} << lvl) <= n; lvl++) {
+        const int64_t x = int64_t{1} << (lvl - 1);
+        const int64_t i_first = (x << 1) - 1;
+        const int64_t step = x << 2;
+
+        for (int64_t i = i_first; i < n; i += step) {
+            auto left_max = max_pa_end_[i - x];
+            auto right_max = i + x < n ? max_pa_end_[i + x] : last_max;
+            max_pa_end_[i] = std::max({PaEnd(vm_entries_[i]), left_max, right_max});
+        }
+
+        last_i = (last_i >> lvl & 1) ? last_i - x : last_i + x;
+        if (last_i < n && max_pa_end_[last_i] > last_max)
+            last_max = max_pa_end_[last_i];
+    }
+
+    max_lvl_ = lvl - 1;
+}
+
+// Find VA space range(s) the physical address space [pa_start, pa_end)
 // is mapped into.
-// It is possible that only a fraction of the physical address space is mapped.
-// TODO: use interval tree instead?
+// It is possible that only a fraction of the physical address space is mapped,
+// or the mapping starts below @pa_start.
 std::vector<vm::VmallocEntry>
-vm::VmallocStats::GetMappingInRange(uint64_t pa_start, uint64_t pa_end)
+vm::VmallocStats::GetMappingInRange(uint64_t pa_start, uint64_t pa_end) const
 {
     std::vector<VmallocEntry> result;
 
-    auto lb = std::ranges::lower_bound(vm_entries_, pa_start, std::less<>{}, &VmallocEntry::pa_);
-    auto ub = std::ranges::upper_bound(vm_entries_, pa_end - 1, std::less<>{}, &VmallocEntry::pa_);
-    std::ranges::copy(lb, ub, std::back_inserter(result));
+    ForEachMappingInRange(pa_start, pa_end, [&](const auto &e) { result.push_back(e); });
 
     if (!result.empty()) {
         logger.log(Verbosity::INFO, "Found VA mapping for PA range [{:#x} - {:#x}]:", pa_start, pa_end);
@@ -45,10 +91,92 @@ vm::VmallocStats::GetMappingInRange(uint64_t pa_start, uint64_t pa_end)
     return result;
 }
 
+// Parse hex address with optional '0x' prefix. The whole @str must be consumed.
+static bool ParseHexAddr(std::string_view str, uint64_t &val) noexcept
+{
+    if (str.starts_with("0x"))
+        str.remove_prefix(2);
+
+    if (str.empty())
+        return false;
+
+    auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.length(), val, 16);
+    return ec == std::errc() && ptr == str.data() + str.length();
+}
+
+// Parse single ioremap line of /proc/vmallocinfo:
+// <VA start>-<VA end> <size> <caller> phys=<PA> ioremap
+static bool ParseIoremapLine(std::string_view line, vm::VmallocEntry &entry) noexcept
+{
+    auto dash_pos = line.find('-');
+    if (dash_pos == std::string_view::npos ||
+        !ParseHexAddr(line.substr(0, dash_pos), entry.start_))
+        return false;
+
+    auto ws_pos = line.find(' ', dash_pos);
+    if (ws_pos == std::string_view::npos ||
+        !ParseHexAddr(line.substr(dash_pos + 1, ws_pos - dash_pos - 1), entry.end_))
+        return false;
+
+    auto pa_pos = line.find("phys=", ws_pos);
+    if (pa_pos == std::string_view::npos)
+        return false;
+    pa_pos += 5;
+
+    auto pa_end_pos = line.find(' ', pa_pos);
+    if (pa_end_pos == std::string_view::npos ||
+        !ParseHexAddr(line.substr(pa_pos, pa_end_pos - pa_pos), entry.pa_))
+        return false;
+
+    if (entry.end_ < entry.start_ + vm::pg_size)
+        return false;
+
+    entry.end_ -= vm::pg_size;
+    entry.len_ = entry.end_ - entry.start_;
+
+    return true;
+}
+
+// Parse all ioremap lines within the @block of complete lines.
+// Lines are located by searching for "ioremap\n" tag directly, so all the other
+// lines are never looked at.
+size_t vm::VmallocStats::ParseBlock(std::string_view block)
+{
+    constexpr std::string_view tag {"ioremap\n"};
+    size_t skipped = 0;
+    size_t pos = 0;
+
+    while (pos < block.length()) {
+        auto tag_ptr = static_cast<const char *>(
+                memmem(block.data() + pos, block.length() - pos, tag.data(), tag.length()));
+        if (tag_ptr == nullptr)
+            break;
+
+        size_t tag_pos = tag_ptr - block.data();
+        auto line_spos = block.rfind('\n', tag_pos);
+        line_spos = (line_spos == std::string_view::npos) ? 0 : line_spos + 1;
+
+        VmallocEntry entry;
+        auto line = block.substr(line_spos, tag_pos + tag.length() - 1 - line_spos);
+        if (ParseIoremapLine(line, entry))
+            vm_entries_.push_back(entry);
+        else
+            skipped++;
+
+        pos = tag_pos + tag.length();
+    }
+
+    return skipped;
+}
+
 // Parse /proc/vmallocinfo in order to know how exactly a portion of
 // physical address space assigned to the particular PCI device is
 // remapped into the kernel virtual address space.
 //
+// The file is read in big blocks into a single reusable buffer,
+// incomplete last line of the block is moved to the beginning of the buffer
+// and completed by the next read.
+//
 // NOTE: vmalloc allocations in the Linux kernel use guard pages by default
 // to capture illegal out-of-bound accesses unless `VM_NO_GUARD` flag is set.
 // This flag is not set for ioremap, so the reported VA range length
@@ -56,51 +184,68 @@ vm::VmallocStats::GetMappingInRange(uint64_t pa_start, uint64_t pa_end)
 // See mm/vmalloc.c: __get_vm_area_node() for details.
 void vm::VmallocStats::Parse()
 {
-    try {
-        std::ifstream proc_vminfo(VmallocInfoFile.data(), std::ios::in);
-        if (!proc_vminfo.is_open()) {
-            logger.log(Verbosity::ERR, "Failed to open /proc/vmallocinfo");
+    auto fd = open(VmallocInfoFile.data(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        logger.log(Verbosity::ERR, "Failed to open /proc/vmallocinfo, err {}", errno);
+        return;
+    }
+
+    auto buf = std::make_unique<char[]>(vminfo_read_block_size);
+    size_t data_len = 0;
+    size_t skipped = 0;
+    bool   eof = false;
+
+    while (!eof) {
+        auto res = read(fd, buf.get() + data_len, vminfo_read_block_size - data_len);
+        if (res < 0) {
+            if (errno == EINTR)
+                continue;
+
+            logger.log(Verbosity::ERR, "Failed to read /proc/vmallocinfo, err {}", errno);
+            close(fd);
+            vm_entries_.clear();
             return;
         }
 
-        std::string mapping_entry;
-        while (std::getline(proc_vminfo, mapping_entry)) {
+        data_len += res;
 
-            // Not interested in non-ioremap allocations for now
-            if (!mapping_entry.ends_with("ioremap"))
-                continue;
+        if (res == 0) {
+            eof = true;
+            // last line might be not terminated
+            if (data_len != 0 && buf[data_len - 1] != '\n') {
+                if (data_len == vminfo_read_block_size)
+                    data_len--;
+                buf[data_len++] = '\n';
+            }
+        }
 
-            VmallocEntry entry;
-            std::string::size_type s_pos = 0, e_pos;
-
-            // VA start
-            e_pos = mapping_entry.find("-");
-            entry.start_ = std::stoull(mapping_entry.substr(s_pos, e_pos - s_pos),
-                                      nullptr, 16);
-            // VA end
-            s_pos = e_pos + 1;
-            e_pos = mapping_entry.find(" ");
-            entry.end_ = std::stoull(mapping_entry.substr(s_pos, e_pos - s_pos),
-                                    nullptr, 16);
-            entry.end_ -= vm::pg_size;
-            entry.len_ = entry.end_ - entry.start_;
-
-            // phys addr
-            s_pos = mapping_entry.find("=", e_pos) + 1;
-            e_pos = mapping_entry.find(" ", s_pos);
-            entry.pa_ = std::stoull(mapping_entry.substr(s_pos, e_pos - s_pos),
-                                   nullptr, 16);
-            vm_entries_.push_back(std::move(entry));
+        std::string_view data {buf.get(), data_len};
+        auto last_nl_pos = data.rfind('\n');
+        if (last_nl_pos == std::string_view::npos) {
+            // a single line doesn't fit into the buffer, drop it
+            if (data_len == vminfo_read_block_size) {
+                skipped++;
+                data_len = 0;
+            }
+            continue;
         }
 
-        std::ranges::sort(vm_entries_, [](const auto &a, const auto &b) {
-                          return a.pa_ < b.pa_; });
+        skipped += ParseBlock(data.substr(0, last_nl_pos + 1));
 
-        vm_info_available_ = true;
-    } catch (std::exception &ex) {
-        logger.log(Verbosity::ERR, "Exception occured while parsing /proc/vmallocinfo: {}", ex.what());
-        throw;
+        auto tail_len = data_len - last_nl_pos - 1;
+        std::memmove(buf.get(), buf.get() + last_nl_pos + 1, tail_len);
+        data_len = tail_len;
     }
+
+    close(fd);
+
+    if (skipped != 0)
+        logger.log(Verbosity::WARN, "/proc/vmallocinfo: {} malformed ioremap entries skipped",
+                   skipped);
+
+    BuildIndex();
+
+    vm_info_available_ = true;
 }
 
 bool sys::IsKptrSet()
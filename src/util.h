@@ -4,10 +4,16 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
 #include <vector>
 #include <cstdint>
 #include <string_view>
 #include <cassert>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <utility>
 
 // Explicit scoped enums to underlying type conversion
 template <typename E>
@@ -32,10 +38,109 @@ struct CTMap
     }
 };
 
+// Blocking bounded multi-producer/multi-consumer queue
+template <typename T>
+class BoundedQueue
+{
+    std::mutex              mtx_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    std::deque<T>           queue_;
+    size_t                  capacity_;
+    bool                    closed_ {false};
+
+public:
+    explicit BoundedQueue(const size_t capacity) : capacity_(capacity) {}
+
+    // Block while the queue is full. Returns false if the queue has been closed.
+    bool Push(T &&val)
+    {
+        std::unique_lock lock(mtx_);
+        not_full_.wait(lock, [this] { return closed_ || queue_.size() < capacity_; });
+        if (closed_)
+            return false;
+
+        queue_.push_back(std::move(val));
+        lock.unlock();
+        not_empty_.notify_one();
+        return true;
+    }
+
+    // Block while the queue is empty.
+    // Returns std::nullopt once the queue has been closed and drained.
+    std::optional<T> Pop()
+    {
+        std::unique_lock lock(mtx_);
+        not_empty_.wait(lock, [this] { return closed_ || !queue_.empty(); });
+        if (queue_.empty())
+            return std::nullopt;
+
+        auto val = std::move(queue_.front());
+        queue_.pop_front();
+        lock.unlock();
+        not_full_.notify_one();
+        return val;
+    }
+
+    // No more elements would be pushed, consumers drain the rest
+    void Close()
+    {
+        {
+            std::lock_guard lock(mtx_);
+            closed_ = true;
+        }
+        not_empty_.notify_all();
+        not_full_.notify_all();
+    }
+};
+
+// Stable LSD radix sort of @vals by 64-bit unsigned key returned by @key_fn.
+// Keys are computed once, byte passes where all keys share the same digit
+// are skipped, so the sort is linear in the number of elements.
+template <typename T, typename KeyFn>
+void RadixSort(std::vector<T> &vals, KeyFn &&key_fn)
+{
+    using Entry = std::pair<uint64_t, T>;
+
+    if (vals.size() < 2)
+        return;
+
+    std::vector<Entry> src, dst(vals.size());
+    src.reserve(vals.size());
+    for (auto &val : vals)
+        src.emplace_back(key_fn(val), std::move(val));
+
+    // bits which differ at least in one key
+    uint64_t diff_bits = 0;
+    for (const auto &entry : src)
+        diff_bits |= entry.first ^ src.front().first;
+
+    for (uint32_t shift = 0; shift < 64; shift += 8) {
+        if (((diff_bits >> shift) & 0xff) == 0)
+            continue;
+
+        std::array<size_t, 256> pos {};
+        for (const auto &entry : src)
+            pos[(entry.first >> shift) & 0xff]++;
+
+        for (size_t i = 0, sum = 0; i < pos.size(); i++)
+            sum += std::exchange(pos[i], sum);
+
+        for (auto &entry : src)
+            dst[pos[(entry.first >> shift) & 0xff]++] = std::move(entry);
+
+        src.swap(dst);
+    }
+
+    for (size_t i = 0; i < vals.size(); i++)
+        vals[i] = std::move(src[i].second);
+}
+
 namespace vm {
 
 constexpr int pg_size = 4096;
 constexpr std::string_view VmallocInfoFile { "/proc/vmallocinfo" };
+constexpr size_t vminfo_read_block_size = 256 * 1024;
 
 /* This object repesents a struct vm_struct of the Linux kernel */
 struct VmallocEntry
@@ -46,20 +151,88 @@ struct VmallocEntry
     uint64_t pa_;
 };
 
+// Physical address space ranges [pa_, pa_ + len_) of vmalloc entries
+// are indexed by an implicit augmented interval tree:
+// entries are sorted by @pa_, and the sorted array itself is treated as
+// a complete binary search tree, where the node at index i belongs to
+// the level equal to the number of trailing 1 bits of i.
+// Each node is annotated with the max PA end of its subtree (@max_pa_end_),
+// so subtrees, which cannot overlap the query range, are skipped.
 class VmallocStats
 {
 private:
     std::vector<VmallocEntry> vm_entries_;
+    std::vector<uint64_t>     max_pa_end_;
+    int                       max_lvl_ {-1};
     bool                      vm_info_available_ {false};
 
+    static uint64_t PaEnd(const VmallocEntry &e) noexcept { return e.pa_ + e.len_; }
+
+    // returns the number of skipped malformed entries
+    size_t ParseBlock(std::string_view block);
+
 public:
+    // NOTE: @BuildIndex must be called after entries have been added
     void AddEntry(const VmallocEntry &entry);
+    void BuildIndex();
     void DumpStats();
     void Parse();
     bool InfoAvailable() { return vm_info_available_; }
-    std::vector<VmallocEntry> GetMappingInRange(uint64_t start, uint64_t end);
+
+    // Call @fn for each entry, PA range of which overlaps [pa_start, pa_end),
+    // entries are visited in ascending PA order
+    template <typename F>
+    void ForEachMappingInRange(uint64_t pa_start, uint64_t pa_end, F &&fn) const;
+
+    std::vector<VmallocEntry> GetMappingInRange(uint64_t start, uint64_t end) const;
 };
 
+template <typename F>
+void VmallocStats::ForEachMappingInRange(uint64_t pa_start, uint64_t pa_end, F &&fn) const
+{
+    // node index, level, left subtree has already been visited
+    struct StackElem
+    {
+        int64_t idx;
+        int     lvl;
+        bool    left_done;
+    };
+
+    // subtrees of this height or lower are scanned linearly
+    constexpr int scan_lvl = 3;
+
+    const auto n = static_cast<int64_t>(vm_entries_.size());
+    if (max_lvl_ < 0 || n == 0)
+        return;
+
+    std::array<StackElem, 64> stack;
+    int top = 0;
+    stack[top++] = { (int64_t{1} << max_lvl_) - 1, max_lvl_, false };
+
+    while (top != 0) {
+        auto node = stack[--top];
+
+        if (node.lvl <= scan_lvl) {
+            auto i_first = node.idx >> node.lvl << node.lvl;
+            auto i_last = std::min(i_first + (int64_t{1} << (node.lvl + 1)) - 1, n);
+            for (auto i = i_first; i < i_last && vm_entries_[i].pa_ < pa_end; i++)
+                if (pa_start < PaEnd(vm_entries_[i]))
+                    fn(vm_entries_[i]);
+        } else if (!node.left_done) {
+            // revisit the node after the left subtree
+            auto left = node.idx - (int64_t{1} << (node.lvl - 1));
+            stack[top++] = { node.idx, node.lvl, true };
+            // left child might be out of range in case of incomplete tree
+            if (left >= n || max_pa_end_[left] > pa_start)
+                stack[top++] = { left, node.lvl - 1, false };
+        } else if (node.idx < n && vm_entries_[node.idx].pa_ < pa_end) {
+            if (pa_start < PaEnd(vm_entries_[node.idx]))
+                fn(vm_entries_[node.idx]);
+            stack[top++] = { node.idx + (int64_t{1} << (node.lvl - 1)), node.lvl - 1, false };
+        }
+    }
+}
+
 } /* namespace vm */
 
 
@@ -0,0 +1,286 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2025 Petr Vyazovik <xen@f-m.fm>
+
+// Build-time generator of the embedded PCI ids database.
+// Converts pci.ids file into a translation unit holding a set of
+// constexpr perfect-hashed tables (see src/ids_embedded.h).
+//
+// usage: ids_embed_gen <path/to/pci.ids> <path/to/output.cpp>
+
+#include "ids_embedded.h"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdio>
+#include <fstream>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using namespace pci::embedded;
+
+constexpr auto tables_cnt = static_cast<size_t>(IdsTableType::TABLES_CNT);
+
+struct GenEntry
+{
+    uint64_t key_;
+    uint32_t name_off_;
+    uint32_t name_len_;
+};
+
+struct GenTable
+{
+    std::vector<GenEntry>        entries_;
+    std::unordered_set<uint64_t> keys_;
+    std::vector<IdsEntry>        slots_;
+    std::vector<uint32_t>        disp_;
+};
+
+static bool ParseHexId(std::string_view str, size_t off, size_t len, uint64_t &id)
+{
+    if (str.length() < off + len)
+        return false;
+
+    auto [ptr, ec] = std::from_chars(str.data() + off, str.data() + off + len, id, 16);
+    return ec == std::errc() && ptr == str.data() + off + len;
+}
+
+// Build hash and displace perfect hash table out of @table.entries_
+static bool BuildPerfectHash(GenTable &table)
+{
+    const auto entries_cnt = table.entries_.size();
+    if (entries_cnt == 0)
+        return true;
+
+    // ~0.8 load factor, ~4 keys per bucket
+    const size_t slots_cnt = entries_cnt + entries_cnt / 4 + 1;
+    const size_t buckets_cnt = entries_cnt / 4 + 1;
+
+    std::vector<std::vector<const GenEntry *>> buckets(buckets_cnt);
+    for (const auto &entry : table.entries_)
+        buckets[IdsHash(entry.key_, 0) % buckets_cnt].push_back(&entry);
+
+    // place the biggest buckets first, while most of the slots are still free
+    std::vector<size_t> order(buckets_cnt);
+    std::iota(order.begin(), order.end(), 0);
+    std::ranges::stable_sort(order, [&](auto a, auto b) {
+        return buckets[a].size() > buckets[b].size(); });
+
+    table.slots_.assign(slots_cnt, IdsEntry{0, 0, 0});
+    table.disp_.assign(buckets_cnt, 0);
+
+    std::vector<bool>   used(slots_cnt, false);
+    std::vector<size_t> cur_slots;
+
+    for (auto b_idx : order) {
+        const auto &bucket = buckets[b_idx];
+        if (bucket.empty())
+            break;
+
+        bool placed = false;
+        for (uint32_t disp = 1; disp < (1u << 24) && !placed; disp++) {
+            cur_slots.clear();
+            placed = true;
+            for (const auto *entry : bucket) {
+                auto slot = IdsHash(entry->key_, disp) % slots_cnt;
+                if (used[slot] || std::ranges::find(cur_slots, slot) != cur_slots.end()) {
+                    placed = false;
+                    break;
+                }
+                cur_slots.push_back(slot);
+            }
+
+            if (placed) {
+                table.disp_[b_idx] = disp;
+                for (size_t i = 0; i < bucket.size(); i++) {
+                    used[cur_slots[i]] = true;
+                    table.slots_[cur_slots[i]] = { bucket[i]->key_, bucket[i]->name_off_,
+                                                   bucket[i]->name_len_ };
+                }
+            }
+        }
+
+        if (!placed)
+            return false;
+    }
+
+    return true;
+}
+
+static std::string EscapeStr(std::string_view str)
+{
+    std::string res;
+    for (unsigned char c : str) {
+        if (c == '"' || c == '\\') {
+            res += '\\';
+            res += c;
+        } else if (c < 0x20 || c >= 0x7f) {
+            char oct[5];
+            std::snprintf(oct, sizeof(oct), "\\%03o", c);
+            res += oct;
+        } else {
+            res += c;
+        }
+    }
+    return res;
+}
+
+static const char *TableName(size_t idx)
+{
+    constexpr const char *names[] {
+        "vendor", "device", "subsys", "class", "subclass", "prog_iface"
+    };
+    return names[idx];
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 3) {
+        std::fprintf(stderr, "usage: %s <path/to/pci.ids> <path/to/output.cpp>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::ifstream ids_file(argv[1]);
+    if (!ids_file.is_open()) {
+        std::fprintf(stderr, "Failed to open PCI ids db %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    std::array<GenTable, tables_cnt> tables;
+    std::string names, version;
+
+    auto add_entry = [&](IdsTableType type, uint64_t key, std::string_view name) {
+        auto &table = tables[static_cast<size_t>(type)];
+        // first occurrence wins, the same way as during the db text search
+        if (name.empty() || !table.keys_.insert(key).second)
+            return;
+        table.entries_.push_back({key, static_cast<uint32_t>(names.size()),
+                                  static_cast<uint32_t>(name.size())});
+        names += name;
+    };
+
+    bool        in_class_block = false;
+    bool        lvl1_valid = false, lvl2_valid = false;
+    uint64_t    lvl1_id = 0, lvl2_id = 0;
+    std::string line;
+
+    while (std::getline(ids_file, line)) {
+        std::string_view lv {line};
+        uint64_t id, sub_id;
+
+        if (lv.empty())
+            continue;
+
+        if (lv[0] == '#') {
+            // '# Version: YYYY.MM.DD'
+            auto ver_pos = lv.find("Version: ");
+            if (version.empty() && ver_pos != std::string_view::npos)
+                version = lv.substr(ver_pos + 9);
+            continue;
+        }
+
+        if (lv.starts_with("C ")) {
+            in_class_block = true;
+            lvl2_valid = false;
+            lvl1_valid = ParseHexId(lv, 2, 2, lvl1_id);
+            if (lvl1_valid)
+                add_entry(IdsTableType::CLASS, lvl1_id, lv.substr(std::min<size_t>(6, lv.size())));
+        } else if (lv[0] != '\t') {
+            in_class_block = false;
+            lvl2_valid = false;
+            lvl1_valid = ParseHexId(lv, 0, 4, lvl1_id);
+            if (lvl1_valid)
+                add_entry(IdsTableType::VENDOR, lvl1_id, lv.substr(std::min<size_t>(6, lv.size())));
+        } else if (lv.length() < 2 || lv[1] != '\t') {
+            auto id_len = in_class_block ? 2 : 4;
+            lvl2_valid = lvl1_valid && ParseHexId(lv, 1, id_len, id);
+            if (!lvl2_valid)
+                continue;
+
+            auto name = lv.substr(std::min<size_t>(1 + id_len + 2, lv.size()));
+            if (in_class_block) {
+                lvl2_id = lvl1_id << 8 | id;
+                add_entry(IdsTableType::SUBCLASS, lvl2_id, name);
+            } else {
+                lvl2_id = lvl1_id << 16 | id;
+                add_entry(IdsTableType::DEVICE, lvl2_id, name);
+            }
+        } else {
+            if (!lvl2_valid)
+                continue;
+
+            if (in_class_block) {
+                if (ParseHexId(lv, 2, 2, id))
+                    add_entry(IdsTableType::PROG_IFACE, lvl2_id << 8 | id,
+                              lv.substr(std::min<size_t>(2 + 2 + 2, lv.size())));
+            } else {
+                if (ParseHexId(lv, 2, 4, id) && ParseHexId(lv, 7, 4, sub_id))
+                    add_entry(IdsTableType::SUBSYS, lvl2_id << 32 | id << 16 | sub_id,
+                              lv.substr(std::min<size_t>(2 + 4 + 1 + 4 + 2, lv.size())));
+            }
+        }
+    }
+
+    for (size_t i = 0; i < tables_cnt; i++) {
+        if (!BuildPerfectHash(tables[i])) {
+            std::fprintf(stderr, "Failed to build perfect hash for %s table\n", TableName(i));
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::ostringstream out;
+    out << "// Generated by ids_embed_gen from " << EscapeStr(argv[1]) << ". Do not edit.\n\n"
+        << "#include \"ids_embedded.h\"\n\n"
+        << "namespace pci::embedded {\n\n";
+
+    out << "extern const char ids_version[] = \"" << EscapeStr(version) << "\";\n\n";
+
+    out << "extern const char ids_names[] =";
+    for (size_t pos = 0; pos < names.size(); pos += 96)
+        out << "\n    \"" << EscapeStr(std::string_view(names).substr(pos, 96)) << "\"";
+    if (names.empty())
+        out << " \"\"";
+    out << ";\n\n";
+
+    for (size_t i = 0; i < tables_cnt; i++) {
+        const auto &table = tables[i];
+
+        out << "static constexpr IdsEntry " << TableName(i) << "_slots[] = {\n";
+        for (const auto &slot : table.slots_)
+            out << "    {0x" << std::hex << slot.key_ << std::dec << "ULL, "
+                << slot.name_off_ << ", " << slot.name_len_ << "},\n";
+        if (table.slots_.empty())
+            out << "    {0, 0, 0}\n";
+        out << "};\n\n";
+
+        out << "static constexpr uint32_t " << TableName(i) << "_disp[] = {";
+        for (size_t j = 0; j < table.disp_.size(); j++)
+            out << (j % 16 ? " " : "\n    ") << table.disp_[j] << ",";
+        if (table.disp_.empty())
+            out << " 0";
+        out << "\n};\n\n";
+    }
+
+    out << "extern const IdsTable ids_tables[" << tables_cnt << "] = {\n";
+    for (size_t i = 0; i < tables_cnt; i++)
+        out << "    { " << TableName(i) << "_slots, " << tables[i].slots_.size() << ", "
+            << TableName(i) << "_disp, " << tables[i].disp_.size() << " },\n";
+    out << "};\n\n"
+        << "} // namespace pci::embedded\n";
+
+    std::ofstream out_file(argv[2], std::ios::binary | std::ios::trunc);
+    if (!out_file.is_open()) {
+        std::fprintf(stderr, "Failed to open output file %s\n", argv[2]);
+        return EXIT_FAILURE;
+    }
+    out_file << out.str();
+
+    std::fprintf(stdout, "PCI ids db %s: vendors %zu devices %zu subsystems %zu classes %zu\n",
+                 version.c_str(), tables[0].entries_.size(), tables[1].entries_.size(),
+                 tables[2].entries_.size(), tables[3].entries_.size());
+
+    return out_file.good() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
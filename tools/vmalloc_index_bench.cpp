@@ -0,0 +1,103 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright (C) 2025 Petr Vyazovik <xen@f-m.fm>
+
+// Benchmark of the vmalloc entries PA index (see vm::VmallocStats).
+// Random mappings are indexed, then random range queries are timed and
+// checked against a brute-force scan.
+//
+// usage: vmalloc_index_bench [entries_cnt...] (default: 100000 200000)
+
+#include "config.h"
+#include "log.h"
+#include "util.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <print>
+#include <random>
+#include <string>
+#include <vector>
+
+cfg::PCIexCfg pciex_cfg;
+Logger        logger;
+
+constexpr size_t   queries_cnt = 2000;
+constexpr uint64_t pa_space_size = 1ULL << 40;
+
+struct BenchResult
+{
+    double ns_per_query_;
+    size_t matches_;
+    size_t mismatches_;
+};
+
+static BenchResult RunBench(const size_t entries_cnt, std::mt19937_64 &rng)
+{
+    std::uniform_int_distribution<uint64_t> pa_dist(0, pa_space_size);
+    // most of the mappings are 4K-256K, 1% of them are up to 1G
+    std::uniform_int_distribution<uint64_t> small_pages(1, 64);
+    std::uniform_int_distribution<uint64_t> large_pages(1, 1ULL << 18);
+    std::uniform_int_distribution<int>      percent(0, 99);
+
+    vm::VmallocStats stats;
+    std::vector<vm::VmallocEntry> entries;
+    entries.reserve(entries_cnt);
+
+    for (size_t i = 0; i < entries_cnt; i++) {
+        const uint64_t len = (percent(rng) == 0 ? large_pages(rng) : small_pages(rng)) * 4096;
+        const uint64_t pa = pa_dist(rng) & ~0xfffULL;
+        const vm::VmallocEntry entry {0xffffc90000000000ULL + i * 0x10000,
+                                      0xffffc90000000000ULL + i * 0x10000 + len, len, pa};
+        entries.push_back(entry);
+        stats.AddEntry(entry);
+    }
+    stats.BuildIndex();
+
+    // BAR-like query ranges
+    std::vector<std::pair<uint64_t, uint64_t>> queries;
+    queries.reserve(queries_cnt);
+    for (size_t i = 0; i < queries_cnt; i++) {
+        const uint64_t start = pa_dist(rng) & ~0xfffULL;
+        queries.emplace_back(start, start + small_pages(rng) * 4096);
+    }
+
+    size_t matches = 0;
+    const auto t_start = std::chrono::steady_clock::now();
+    for (const auto &[start, end] : queries)
+        stats.ForEachMappingInRange(start, end, [&](const auto &) { matches++; });
+    const auto t_end = std::chrono::steady_clock::now();
+
+    size_t mismatches = 0;
+    for (const auto &[start, end] : queries) {
+        size_t expected = 0, found = 0;
+        for (const auto &entry : entries)
+            if (entry.pa_ < end && start < entry.pa_ + entry.len_)
+                expected++;
+        stats.ForEachMappingInRange(start, end, [&](const auto &) { found++; });
+        if (found != expected)
+            mismatches++;
+    }
+
+    const std::chrono::duration<double, std::nano> elapsed = t_end - t_start;
+    return {elapsed.count() / queries_cnt, matches, mismatches};
+}
+
+int main(int argc, char *argv[])
+{
+    std::vector<size_t> sizes;
+    for (int i = 1; i < argc; i++)
+        sizes.push_back(std::stoul(argv[i]));
+    if (sizes.empty())
+        sizes = {100000, 200000};
+
+    std::mt19937_64 rng(42);
+    bool ok = true;
+    for (auto entries_cnt : sizes) {
+        auto res = RunBench(entries_cnt, rng);
+        std::print("{:>8} entries: {:>8.1f} ns/query, {} matches, {} mismatches\n",
+                   entries_cnt, res.ns_per_query_, res.matches_, res.mismatches_);
+        ok = ok && res.mismatches_ == 0;
+    }
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}